@@ -0,0 +1,52 @@
+#pragma once
+
+// Helpers of the benchmarks in bench/, they are built by "make bench"
+#include <algorithm> // copy
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include "trajectory_store.hpp"
+
+// Wall time since construction or the last restart
+class stopwatch_t
+{
+	public:
+	stopwatch_t(): _start(std::chrono::steady_clock::now()) { }
+
+	void restart() { _start = std::chrono::steady_clock::now(); }
+	double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count(); }
+
+	private:
+	std::chrono::steady_clock::time_point _start;
+}; // stopwatch_t
+
+// A larger data set of the same shape: all trajectories of in are appended to out scale times
+inline void scale_trajectories(const trajectory_store_t & in, size_t scale, trajectory_store_t & out)
+{
+	out.clear();
+	for(size_t k=0; k<scale; ++k) {
+		for(size_t i=0; i<in.size(); ++i) {
+			size_t id = out.append(in.length(i), in.start_frame(i));
+			std::copy(in.x(i).begin(), in.x(i).end(), out._x.begin() + out._offsets[id]);
+			std::copy(in.y(i).begin(), in.y(i).end(), out._y.begin() + out._offsets[id]);
+		}
+	}
+}
+
+inline void scale_partitions(const partition_store_t & in, size_t scale, partition_store_t & out)
+{
+	out.clear();
+	for(size_t k=0; k<scale; ++k) {
+		for(size_t i=0; i<in.size(); ++i) {
+			size_t id = out.append(in[i].size());
+			std::copy(in[i].begin(), in[i].end(), out._cut_points.begin() + out._offsets[id]);
+		}
+	}
+}
+
+inline double file_megabytes(const std::string & path)
+{
+	std::ifstream in(path.c_str(), std::ios::binary | std::ios::ate);
+	return in? in.tellg()/1e6: 0.0;
+}
@@ -0,0 +1,140 @@
+// Drawing of trajectories on all frames: the former draw_frame() (HSV round trip and a cv::rectangle per point)
+// against trajectory_rasterizer_t, serial and on all cores, with trajectories and partitions repeated <scale> times
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib> // atoi
+#include <cmath> // floor
+#include <thread> // hardware_concurrency
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "bench.hpp"
+#include "trajectory_store.hpp"
+#include "frame_index.hpp"
+#include "trajectory_rasterizer.hpp"
+#include "dat_reader.hpp"
+
+const int indent = 1; // as in main.cpp
+
+// draw_frame() of main.cpp as it was before trajectory_rasterizer_t
+static void draw_frame(const frame_index_t & index, unsigned int frame_id, const cv::Mat & frame, cv::Mat & out)
+{
+	int width = frame.size().width;
+	int height = frame.size().height;
+
+	cv::cvtColor(frame, out, CV_BGR2HSV);
+
+	const int hue_step_deg = 30;
+	const int saturation = 255;
+	const int value = 255;
+
+	for(const frame_point_t & point : index[frame_id]) {
+		int hue = (point._segment*hue_step_deg)%360;
+		cv::Scalar color = (point._segment == 0)? cv::Scalar(hue, 0, 0): cv::Scalar(hue, saturation, value);
+
+		int floor_x = floor(point._x);
+		int floor_y = floor(point._y);
+		int ceil_x = floor_x + 1;
+		int ceil_y = floor_y + 1;
+
+		cv::Point p1, p2;
+		p1.x = (floor_x-indent<0)? 0: floor_x-indent;
+		p1.y = (floor_y-indent<0)? 0: floor_y-indent;
+		p2.x = (ceil_x+indent>=width-1)? width-1: ceil_x+indent;
+		p2.y = (ceil_y+indent>=height-1)? height-1: ceil_y+indent;
+
+		cv::rectangle(out, p1, p2, color, CV_FILLED);
+	}
+	cv::cvtColor(out, out, CV_HSV2BGR);
+}
+
+static size_t count_different_pixels(const cv::Mat & a, const cv::Mat & b)
+{
+	size_t amount = 0;
+	for(int y=0; y<a.rows; ++y) {
+		const cv::Vec3b * row_a = a.ptr<cv::Vec3b>(y);
+		const cv::Vec3b * row_b = b.ptr<cv::Vec3b>(y);
+		for(int x=0; x<a.cols; ++x) {
+			if(row_a[x][0] != row_b[x][0] || row_a[x][1] != row_b[x][1] || row_a[x][2] != row_b[x][2]) {
+				++amount;
+			}
+		}
+	}
+	return amount;
+}
+
+int main(int argc, char * argv[])
+{
+	if(argc!=1+3 && argc!=1+4) {
+		std::cout << "Usage: " << argv[0] << " <path_to_trajectories> <path_to_partition> <scale> [<path_to_frame>]" << std::endl;
+		std::cout << "Every frame is a copy of <path_to_frame>, 640x480 black frames by default" << std::endl;
+		return 1;
+	}
+	int scale = atoi(argv[3]);
+	if(scale < 1) {
+		std::cout << "Scale must be positive" << std::endl;
+		return 1;
+	}
+
+	int video_length, partitions_video_length;
+	trajectory_store_t trajectories, scaled_trajectories;
+	partition_store_t partitions, scaled_partitions;
+	if( !load_trajectories(argv[1], video_length, trajectories) || !load_partitions(argv[2], partitions_video_length, partitions) ||
+			trajectories.size() != partitions.size() ) {
+		std::cout << "Cannot read " << argv[1] << " and " << argv[2] << std::endl;
+		return 1;
+	}
+	scale_trajectories(trajectories, scale, scaled_trajectories);
+	scale_partitions(partitions, scale, scaled_partitions);
+
+	cv::Mat frame = (argc == 1+4)? cv::imread(argv[4]): cv::Mat(480, 640, CV_8UC3, cv::Scalar(0, 0, 0));
+	if(frame.empty()) {
+		std::cout << "Cannot read " << argv[4] << std::endl;
+		return 1;
+	}
+
+	frame_index_t index;
+	index.build(scaled_trajectories, scaled_partitions, scaled_trajectories.size(), video_length);
+	std::cout << scaled_trajectories.size() << " trajectories, " << index.amount_of_points() << " points in " << video_length
+			<< " frames of " << frame.cols << "x" << frame.rows << std::endl;
+
+	std::vector<cv::Mat> old_frames(video_length);
+	stopwatch_t stopwatch;
+	for(int frame_id=0; frame_id<video_length; ++frame_id) {
+		draw_frame(index, frame_id, frame, old_frames[frame_id]);
+	}
+	double old_time = stopwatch.seconds();
+
+	trajectory_rasterizer_t rasterizer(indent);
+	std::vector<cv::Mat> serial_frames(video_length);
+	stopwatch.restart();
+	for(int frame_id=0; frame_id<video_length; ++frame_id) {
+		frame.copyTo(serial_frames[frame_id]);
+		rasterizer.draw(index, frame_id, serial_frames[frame_id]);
+	}
+	double serial_time = stopwatch.seconds();
+
+	std::vector<cv::Mat> parallel_frames;
+	stopwatch.restart();
+	rasterizer.draw(index, 0, video_length, [&](size_t) { return frame; }, false, parallel_frames);
+	double parallel_time = stopwatch.seconds();
+
+	// outputs of the rasterizer are identical, the former draw_frame() also changes pixels outside trajectories
+	// by the lossy HSV round trip, so it matches only on black frames
+	size_t serial_differences = 0, old_differences = 0;
+	for(int frame_id=0; frame_id<video_length; ++frame_id) {
+		serial_differences += count_different_pixels(serial_frames[frame_id], parallel_frames[frame_id]);
+		old_differences += count_different_pixels(serial_frames[frame_id], old_frames[frame_id]);
+	}
+
+	std::cout << "draw_frame():                  " << old_time*1000/video_length << " ms per frame" << std::endl;
+	std::cout << "trajectory_rasterizer_t:       " << serial_time*1000/video_length << " ms per frame" << std::endl;
+	std::cout << "trajectory_rasterizer_t, " << std::thread::hardware_concurrency() << " threads: "
+			<< parallel_time*1000/video_length << " ms per frame" << std::endl;
+	std::cout << "pixels differing btw serial and parallel: " << serial_differences
+			<< ", btw draw_frame() and the rasterizer: " << old_differences << std::endl;
+	return serial_differences == 0? 0: 1;
+}
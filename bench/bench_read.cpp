@@ -0,0 +1,89 @@
+// Throughput of load_trajectories() against the iostream reader (read() of trajectory_t.cpp) on a scaled copy of a .dat file
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib> // atoi
+
+#include "bench.hpp"
+#include "trajectory_t.hpp"
+#include "trajectory_store.hpp"
+#include "dat_reader.hpp"
+#include "dat_writer.hpp"
+
+const int repetitions = 3; // the best time is reported
+
+int main(int argc, char * argv[])
+{
+	if(argc!=1+3) {
+		std::cout << "Usage: " << argv[0] << " <path_to_trajectories> <scale> <path_to_scaled_trajectories>" << std::endl;
+		std::cout << "The scaled .dat file is written with all trajectories repeated <scale> times" << std::endl;
+		return 1;
+	}
+	std::string path_to_scaled(argv[3]);
+	int scale = atoi(argv[2]);
+	if(scale < 1) {
+		std::cout << "Scale must be positive" << std::endl;
+		return 1;
+	}
+
+	int video_length;
+	trajectory_store_t trajectories, scaled;
+	if( !load_trajectories(argv[1], video_length, trajectories) ) {
+		std::cout << "Cannot read " << argv[1] << std::endl;
+		return 1;
+	}
+	scale_trajectories(trajectories, scale, scaled);
+	if( !save_trajectories(path_to_scaled, video_length, scaled) ) {
+		std::cout << "Cannot write " << path_to_scaled << std::endl;
+		return 1;
+	}
+	double megabytes = file_megabytes(path_to_scaled);
+	std::cout << path_to_scaled << ": " << megabytes << " MB, " << scaled.size() << " trajectories" << std::endl;
+
+	double iostream_time = 0;
+	std::vector<trajectory_t> read_trajectories;
+	for(int r=0; r<repetitions; ++r) {
+		stopwatch_t stopwatch;
+		std::ifstream in(path_to_scaled.c_str());
+		int amount_of_trajectories;
+		read_dat_header(video_length, amount_of_trajectories, in);
+		read_trajectories.resize(amount_of_trajectories);
+		for(trajectory_t & tr : read_trajectories) {
+			read(tr, in);
+		}
+		double time = stopwatch.seconds();
+		iostream_time = (r==0)? time: std::min(iostream_time, time);
+	}
+
+	double mapped_time = 0;
+	trajectory_store_t loaded;
+	for(int r=0; r<repetitions; ++r) {
+		stopwatch_t stopwatch;
+		if( !load_trajectories(path_to_scaled, video_length, loaded) ) {
+			std::cout << "Cannot read " << path_to_scaled << std::endl;
+			return 1;
+		}
+		double time = stopwatch.seconds();
+		mapped_time = (r==0)? time: std::min(mapped_time, time);
+	}
+
+	// both readers must give the same values
+	size_t mismatches = (loaded.size() != read_trajectories.size())? 1: 0;
+	for(size_t i=0; i<loaded.size() && mismatches == 0; ++i) {
+		const trajectory_t & tr = read_trajectories[i];
+		if(loaded.length(i) != tr.size() || loaded.start_frame(i) != tr._start_frame) {
+			++mismatches;
+			continue;
+		}
+		for(size_t j=0; j<tr.size(); ++j) {
+			if( (double)loaded.x(i)[j] != (double)tr[j].x || (double)loaded.y(i)[j] != (double)tr[j].y ) {
+				++mismatches;
+			}
+		}
+	}
+
+	std::cout << "iostream read():     " << iostream_time << " s, " << megabytes/iostream_time << " MB/s" << std::endl;
+	std::cout << "load_trajectories(): " << mapped_time << " s, " << megabytes/mapped_time << " MB/s" << std::endl;
+	std::cout << "mismatches: " << mismatches << std::endl;
+	return mismatches == 0? 0: 1;
+}
@@ -0,0 +1,132 @@
+// Writers of a scaled copy of a .dat file: std::ofstream with std::endl after every line (the former write()),
+// write() with '\n', save_trajectories() through block_writer_t and the binary save_trajectories_bin().
+// The text files must be byte-identical, the .trb file must load back into the same store
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib> // atoi
+#include <cmath> // lroundf
+
+#include "bench.hpp"
+#include "trajectory_t.hpp"
+#include "trajectory_store.hpp"
+#include "dat_reader.hpp"
+#include "dat_writer.hpp"
+#include "trajectory_bin.hpp"
+
+// write() of trajectory_t.cpp as it was before block_writer_t, flushing on every line
+static void write_with_endl(const trajectory_t & tr, std::ofstream & out)
+{
+	out << (int)0/*label*/ << ' ' << tr.size() << std::endl;
+
+	unsigned int frame = tr._start_frame;
+	out << lroundf(tr[0].x) << ' ' << lroundf(tr[0].y) << ' ' << frame++ << std::endl;
+	for(trajectory_t::const_iterator it=1+tr.begin(); it!=tr.end(); ++it) {
+		out << it->x << ' ' << it->y << ' ' << frame++ << std::endl;
+	}
+}
+
+static std::string read_file(const std::string & path)
+{
+	std::ifstream in(path.c_str(), std::ios::binary);
+	std::stringstream content;
+	content << in.rdbuf();
+	return content.str();
+}
+
+int main(int argc, char * argv[])
+{
+	if(argc!=1+3) {
+		std::cout << "Usage: " << argv[0] << " <path_to_trajectories> <scale> <output_prefix>" << std::endl;
+		std::cout << "<output_prefix>endl.dat, <output_prefix>ofstream.dat, <output_prefix>block.dat and <output_prefix>.trb are written" << std::endl;
+		return 1;
+	}
+	std::string prefix(argv[3]);
+	int scale = atoi(argv[2]);
+	if(scale < 1) {
+		std::cout << "Scale must be positive" << std::endl;
+		return 1;
+	}
+
+	int video_length;
+	trajectory_store_t trajectories, scaled;
+	if( !load_trajectories(argv[1], video_length, trajectories) ) {
+		std::cout << "Cannot read " << argv[1] << std::endl;
+		return 1;
+	}
+	scale_trajectories(trajectories, scale, scaled);
+	std::vector<trajectory_t> scaled_trajectories(scaled.size());
+	for(size_t i=0; i<scaled.size(); ++i) {
+		trajectory_t & tr = scaled_trajectories[i];
+		tr.recreate(scaled.length(i), scaled.start_frame(i));
+		for(size_t j=0; j<tr.size(); ++j) {
+			tr[j] = scaled.point(i, j);
+		}
+	}
+
+	std::string endl_path = prefix + "endl.dat";
+	stopwatch_t stopwatch;
+	{
+		std::ofstream out(endl_path.c_str());
+		out << video_length << std::endl << scaled.size() << std::endl;
+		for(const trajectory_t & tr : scaled_trajectories) {
+			write_with_endl(tr, out);
+		}
+	}
+	double endl_time = stopwatch.seconds();
+
+	std::string ofstream_path = prefix + "ofstream.dat";
+	stopwatch.restart();
+	{
+		std::ofstream out(ofstream_path.c_str());
+		write_dat_header(video_length, scaled.size(), out);
+		for(const trajectory_t & tr : scaled_trajectories) {
+			write(tr, out);
+		}
+	}
+	double ofstream_time = stopwatch.seconds();
+
+	std::string block_path = prefix + "block.dat";
+	stopwatch.restart();
+	if( !save_trajectories(block_path, video_length, scaled) ) {
+		std::cout << "Cannot write " << block_path << std::endl;
+		return 1;
+	}
+	double block_time = stopwatch.seconds();
+
+	std::string bin_path = prefix + ".trb";
+	stopwatch.restart();
+	if( !save_trajectories_bin(bin_path, video_length, scaled, std::vector<int>()) ) {
+		std::cout << "Cannot write " << bin_path << std::endl;
+		return 1;
+	}
+	double bin_time = stopwatch.seconds();
+
+	// round trip: the same text, the same values of the text re-read by the current reader and the same binary columns
+	std::string endl_text = read_file(endl_path);
+	bool is_text_identical = endl_text == read_file(ofstream_path) && endl_text == read_file(block_path);
+
+	trajectory_store_t endl_loaded, block_loaded, bin_loaded;
+	int loaded_length;
+	bool is_reread_identical = load_trajectories(endl_path, loaded_length, endl_loaded) && load_trajectories(block_path, loaded_length, block_loaded) &&
+			endl_loaded._x == block_loaded._x && endl_loaded._y == block_loaded._y &&
+			endl_loaded._start_frames == block_loaded._start_frames && endl_loaded._offsets == block_loaded._offsets;
+
+	stopwatch.restart();
+	bool is_bin_identical = load_trajectories_bin(bin_path, loaded_length, bin_loaded);
+	double bin_load_time = stopwatch.seconds();
+	is_bin_identical = is_bin_identical && bin_loaded._x == scaled._x && bin_loaded._y == scaled._y &&
+			bin_loaded._start_frames == scaled._start_frames && bin_loaded._offsets == scaled._offsets;
+
+	double megabytes = file_megabytes(block_path);
+	std::cout << scaled.size() << " trajectories, " << megabytes << " MB of text" << std::endl;
+	std::cout << "ofstream, std::endl:     " << endl_time << " s, " << megabytes/endl_time << " MB/s" << std::endl;
+	std::cout << "ofstream, '\\n':          " << ofstream_time << " s, " << megabytes/ofstream_time << " MB/s" << std::endl;
+	std::cout << "save_trajectories():     " << block_time << " s, " << megabytes/block_time << " MB/s" << std::endl;
+	std::cout << "save_trajectories_bin(): " << bin_time << " s, load_trajectories_bin(): " << bin_load_time << " s" << std::endl;
+	std::cout << "identical text: " << (is_text_identical? "yes": "no") << ", identical values on re-read: " << (is_reread_identical? "yes": "no")
+			<< ", identical .trb round trip: " << (is_bin_identical? "yes": "no") << std::endl;
+	return (is_text_identical && is_reread_identical && is_bin_identical)? 0: 1;
+}
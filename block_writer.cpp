@@ -0,0 +1,175 @@
+#include "block_writer.hpp"
+#include <cassert>
+#include <cmath> // fabs floor signbit
+#include <cstdio> // snprintf
+#include <cstring> // memcpy
+
+// Longest text of a number: "%g" of a double or a 64 bit integer
+static const size_t max_number_length = 32;
+
+block_writer_t::block_writer_t(size_t block_size):
+		_buffer(block_size < 2*max_number_length? 2*max_number_length: block_size), _used(0) { }
+
+block_writer_t::~block_writer_t()
+{
+	close();
+}
+
+bool block_writer_t::open(const std::string & path)
+{
+	close();
+	_out.open(path, std::ios::binary);
+	return _out.is_open();
+}
+
+bool block_writer_t::close()
+{
+	if( !_out.is_open() ) {
+		return false;
+	}
+	flush();
+	bool is_ok = _out.good();
+	_out.close();
+	return is_ok;
+}
+
+bool block_writer_t::is_open() const
+{
+	return _out.is_open();
+}
+
+void block_writer_t::flush()
+{
+	_out.write(_buffer.data(), _used);
+	_used = 0;
+}
+
+void block_writer_t::reserve(size_t size)
+{
+	if(_used + size > _buffer.size()) {
+		flush();
+	}
+}
+
+void block_writer_t::put(char c)
+{
+	reserve(1);
+	_buffer[_used++] = c;
+}
+
+void block_writer_t::put(unsigned long value)
+{
+	reserve(max_number_length);
+	char digits[max_number_length];
+	int n = 0;
+	do {
+		digits[n++] = '0' + value%10;
+		value /= 10;
+	} while(value != 0);
+	while(n > 0) {
+		_buffer[_used++] = digits[--n];
+	}
+}
+
+void block_writer_t::put(long value)
+{
+	if(value < 0) {
+		put('-');
+		put(0ul - (unsigned long)value);
+	} else {
+		put((unsigned long)value);
+	}
+}
+
+// Writes |value| in [1e-4, 999999.5) with 6 significant digits as "%g" does.
+// Returns 0 if the rounding is too close to call, then the caller falls back to snprintf
+static int format_g6(double value, char * out)
+{
+	static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+	static const double bounds[] = { 1e-4, 1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3, 1e4, 1e5 };
+	const double a = std::fabs(value);
+
+	int exponent = -4; // decimal exponent of the first significant digit
+	while(exponent < 5 && a >= bounds[exponent+5]) {
+		++exponent;
+	}
+	int decimals = 5 - exponent;
+
+	double scaled = a * pow10[decimals];
+	double integral = std::floor(scaled);
+	double fraction = scaled - integral;
+	if(std::fabs(fraction - 0.5) < 1e-6) {
+		return 0; // a tie or almost a tie, the exact decimal value decides
+	}
+	unsigned long mantissa = (unsigned long)integral + (fraction > 0.5);
+	if(mantissa >= 1000000) { // rounded up to the next power of ten
+		mantissa /= 10;
+		--decimals;
+	}
+	if(mantissa < 100000 || decimals < 0) {
+		return 0;
+	}
+
+	// strip trailing zeros of the fraction
+	while(decimals > 0 && mantissa%10 == 0) {
+		mantissa /= 10;
+		--decimals;
+	}
+
+	char digits[16];
+	int n = 0;
+	do {
+		digits[n++] = '0' + mantissa%10;
+		mantissa /= 10;
+	} while(mantissa != 0);
+	while(n <= decimals) {
+		digits[n++] = '0'; // leading zeros of numbers less than 1
+	}
+
+	int length = 0;
+	if(value < 0) {
+		out[length++] = '-';
+	}
+	while(n > decimals) {
+		out[length++] = digits[--n];
+	}
+	if(decimals > 0) {
+		out[length++] = '.';
+		while(n > 0) {
+			out[length++] = digits[--n];
+		}
+	}
+	return length;
+}
+
+void block_writer_t::put(double value)
+{
+	reserve(max_number_length);
+	char * out = &_buffer[_used];
+
+	int length = 0;
+	if(value == 0) {
+		if(std::signbit(value)) {
+			out[length++] = '-';
+		}
+		out[length++] = '0';
+	} else if(std::fabs(value) >= 1e-4 && std::fabs(value) < 999999.5) {
+		length = format_g6(value, out);
+	}
+	if(length == 0) {
+		length = snprintf(out, max_number_length, "%g", value);
+	}
+	_used += length;
+}
+
+void block_writer_t::put_raw(const void * data, size_t size)
+{
+	if(size > _buffer.size()) {
+		flush();
+		_out.write((const char*)data, size);
+		return;
+	}
+	reserve(size);
+	memcpy(&_buffer[_used], data, size);
+	_used += size;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Output file that collects text and binary data in a large buffer and writes it in big blocks.
+// Numbers are formatted by hand; the text is the same as operator<< of std::ostream gives by default
+class block_writer_t
+{
+	public:
+	explicit block_writer_t(size_t block_size = 1 << 20);
+	~block_writer_t();
+
+	block_writer_t(const block_writer_t &) = delete;
+	block_writer_t & operator=(const block_writer_t &) = delete;
+
+	bool open(const std::string & path);
+	// Writes the rest of the buffer. Returns false if any write failed
+	bool close();
+	bool is_open() const;
+
+	void put(char c);
+	void put(long value);
+	void put(unsigned long value);
+	void put(int value) { put((long)value); }
+	void put(unsigned int value) { put((unsigned long)value); }
+	// Same as operator<< with the default precision of 6 significant digits (printf "%g")
+	void put(double value);
+	void put_raw(const void * data, size_t size);
+
+	private:
+	void reserve(size_t size);
+	void flush();
+
+	std::ofstream _out;
+	std::vector<char> _buffer;
+	size_t _used;
+}; // block_writer_t
@@ -0,0 +1,67 @@
+#include "compressed_sequence.hpp"
+
+#include <algorithm> // min max
+#include <atomic>
+#include <thread>
+
+#include <opencv2/highgui/highgui.hpp>
+
+void compressed_sequence_t::open(const std::vector<std::string> & paths, const export_format_t & format, unsigned int num_threads)
+{
+	close();
+	_images.resize(paths.size());
+	_sizes.resize(paths.size());
+
+	std::string extension = format._type == export_format_t::png? ".png": ".jpg";
+	std::vector<int> parameters;
+	parameters.push_back(format._type == export_format_t::png? CV_IMWRITE_PNG_COMPRESSION: CV_IMWRITE_JPEG_QUALITY);
+	parameters.push_back(format._quality);
+
+	if(num_threads == 0) {
+		num_threads = std::thread::hardware_concurrency();
+	}
+	num_threads = std::min<size_t>(std::max(num_threads, 1u), paths.size());
+
+	// as in load_frames, frames are taken one by one from a shared counter.
+	// A decoded frame lives only until it is encoded, so at most num_threads of them are in memory
+	std::atomic<size_t> next_frame(0);
+	auto encode = [&]() {
+		for(size_t i = next_frame++; i < paths.size(); i = next_frame++) {
+			cv::Mat frame = cv::imread(paths[i]);
+			if(frame.data == 0 || !cv::imencode(extension, frame, _images[i], parameters)) {
+				_images[i].clear();
+				continue;
+			}
+			_images[i].shrink_to_fit();
+			_sizes[i] = frame.size();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(unsigned int t=1; t<num_threads; ++t) {
+		workers.push_back(std::thread(encode));
+	}
+	encode();
+	for(std::thread & worker : workers) {
+		worker.join();
+	}
+
+	for(const std::vector<unsigned char> & image : _images) {
+		_memory += image.size();
+	}
+}
+
+void compressed_sequence_t::close()
+{
+	_images.clear();
+	_sizes.clear();
+	_memory = 0;
+}
+
+cv::Mat compressed_sequence_t::decode(size_t frame_id) const
+{
+	if( _images[frame_id].empty() ) {
+		return cv::Mat();
+	}
+	return cv::imdecode(_images[frame_id], CV_LOAD_IMAGE_COLOR);
+}
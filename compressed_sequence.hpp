@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "frame_exporter.hpp" // export_format_t
+
+// A sequence of frames kept in memory as encoded JPEG or PNG images, so a whole video stays resident in a fraction of
+// the memory of decoded frames. Frames are decoded one by one on demand, usually through a small frame_cache_t
+class compressed_sequence_t
+{
+	public:
+	compressed_sequence_t(): _memory(0) { }
+
+	// Decodes files and encodes them in given format by all available cores (or num_threads, if it is positive).
+	// A frame that cannot be read or encoded is left empty, so the caller checks frames in order by frame_size()
+	void open(const std::vector<std::string> & paths, const export_format_t & format, unsigned int num_threads = 0);
+	void close();
+
+	size_t size() const { return _images.size(); }
+	cv::Size frame_size(size_t frame_id) const { return _sizes[frame_id]; } // empty if the frame is not read
+	size_t memory() const { return _memory; } // bytes taken by encoded frames
+
+	// Safe to call from several threads. Returns an empty matrix for a frame that is not read
+	cv::Mat decode(size_t frame_id) const;
+
+	private:
+	std::vector<std::vector<unsigned char> > _images;
+	std::vector<cv::Size> _sizes;
+	size_t _memory;
+}; // compressed_sequence_t
@@ -0,0 +1,153 @@
+#include "dat_follower.hpp"
+#include "dat_scanner.hpp"
+
+static const size_t read_size = 1 << 16;
+static const size_t min_point_bytes = 6; // "0 0 0\n"
+
+enum scan_result_t { scanned, incomplete, malformed };
+
+// A number is cut only at the end of the bytes read so far, anything else will not parse when the writer appends more
+static scan_result_t failure(const dat_scanner_t & scanner)
+{
+	return scanner.eof()? incomplete: malformed;
+}
+
+bool dat_follower_t::open(const std::string & path)
+{
+	_in.open(path, std::ios::binary);
+	_pending.clear();
+	_has_header = false;
+	_is_malformed = false;
+	return _in.is_open();
+}
+
+void dat_follower_t::read_appended()
+{
+	_in.clear(); // reset eof, the file may have grown since
+	for(;;) {
+		size_t size = _pending.size();
+		_pending.resize(size + read_size);
+		_in.read(&_pending[size], read_size);
+		_pending.resize(size + _in.gcount());
+		if( (size_t)_in.gcount() < read_size ) {
+			break;
+		}
+	}
+}
+
+bool dat_follower_t::parse_header()
+{
+	if(_has_header) {
+		return true;
+	}
+	dat_scanner_t scanner(_pending.data(), _pending.data() + _pending.size());
+	int amount_of_elements;
+	if( !scanner.next(_video_length) || !scanner.next(amount_of_elements) || scanner.eof() || _video_length < 0 ) {
+		if(failure(scanner) == malformed) {
+			_is_malformed = true;
+			std::vector<char>().swap(_pending);
+		}
+		return false;
+	}
+	_pending.erase(_pending.begin(), _pending.begin() + (scanner.position() - _pending.data()));
+	_has_header = true;
+	return true;
+}
+
+// A trajectory has at most one point per frame of the video, so does a partition have cut points
+static scan_result_t scan(dat_scanner_t & scanner, size_t video_length, trajectory_t & tr)
+{
+	int label;
+	size_t size;
+	if( !scanner.next(label) || !scanner.next(size) ) {
+		return failure(scanner);
+	}
+	if(size > video_length) {
+		return malformed;
+	}
+	if(size > scanner.remaining() / min_point_bytes) { // the points are not written yet
+		return incomplete;
+	}
+	tr.recreate(size, 0);
+
+	double x, y;
+	int frame;
+	for(size_t i=0; i<size; ++i) {
+		if( !scanner.next(x) || !scanner.next(y) || !scanner.next(frame) ) {
+			return failure(scanner);
+		}
+		tr[i].x = x;
+		tr[i].y = y;
+		if(i == 0) {
+			tr._start_frame = frame;
+		}
+	}
+	return scanned;
+}
+
+static scan_result_t scan(dat_scanner_t & scanner, size_t video_length, partition_t & pr)
+{
+	size_t size;
+	if( !scanner.next(size) ) {
+		return failure(scanner);
+	}
+	if(size > video_length) {
+		return malformed;
+	}
+	pr.clear();
+	for(size_t i=0; i<size; ++i) {
+		partition_t::value_type cut_point;
+		if( !scanner.next(cut_point) ) {
+			return failure(scanner);
+		}
+		pr.push_back(cut_point);
+	}
+	return scanned;
+}
+
+// Appends complete records from pending bytes to the store and drops parsed bytes.
+// A malformed record drops all pending bytes, since nothing after it can be parsed
+template<typename Record, typename Store>
+static size_t parse_records(std::vector<char> & pending, size_t video_length, Record & record, Store & store, bool & is_malformed)
+{
+	dat_scanner_t scanner(pending.data(), pending.data() + pending.size());
+	const char * parsed = scanner.position();
+	size_t amount = 0;
+	scan_result_t result;
+	while( (result = scan(scanner, video_length, record)) == scanned && !scanner.eof() ) { // the last number may be cut by the writer
+		store.push_back(record);
+		parsed = scanner.position();
+		++amount;
+	}
+	if(result == malformed) {
+		is_malformed = true;
+		std::vector<char>().swap(pending);
+		return amount;
+	}
+	pending.erase(pending.begin(), pending.begin() + (parsed - pending.data()));
+	return amount;
+}
+
+size_t dat_follower_t::poll(trajectory_store_t & trajectories)
+{
+	if(_is_malformed) {
+		return 0;
+	}
+	read_appended();
+	if( !parse_header() ) {
+		return 0;
+	}
+	return parse_records(_pending, _video_length, _trajectory, trajectories, _is_malformed);
+}
+
+size_t dat_follower_t::poll(partition_store_t & partitions)
+{
+	if(_is_malformed) {
+		return 0;
+	}
+	read_appended();
+	if( !parse_header() ) {
+		return 0;
+	}
+	return parse_records(_pending, _video_length, _partition, partitions, _is_malformed);
+}
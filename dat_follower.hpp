@@ -0,0 +1,41 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "trajectory_t.hpp"
+#include "trajectory_store.hpp"
+
+// Follows a .dat file that is still being written (e.g. by a tracker), like "tail -f".
+// Every poll() reads only the bytes appended since the previous call and appends complete records to a store.
+// The amount of elements in the header is ignored, since it is not known until the writer finishes.
+// A record is complete when all of its numbers are followed by a whitespace.
+// A record with a token that is not a number is malformed, the file is not followed after it
+class dat_follower_t
+{
+	public:
+	dat_follower_t(): _video_length(0), _has_header(false), _is_malformed(false) { }
+
+	bool open(const std::string & path);
+
+	bool has_header() const { return _has_header; }
+	int video_length() const { return _video_length; }
+	bool is_malformed() const { return _is_malformed; }
+
+	// Return amount of new records
+	size_t poll(trajectory_store_t & trajectories);
+	size_t poll(partition_store_t & partitions);
+
+	private:
+	void read_appended();
+	bool parse_header();
+
+	std::ifstream _in;
+	std::vector<char> _pending; // appended bytes, which are not parsed yet
+	int _video_length;
+	bool _has_header;
+	bool _is_malformed;
+
+	trajectory_t _trajectory;
+	partition_t _partition;
+}; // dat_follower_t
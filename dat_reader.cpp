@@ -0,0 +1,238 @@
+#include "dat_reader.hpp"
+#include "dat_scanner.hpp"
+#include "mapped_file.hpp"
+
+#include <thread>
+
+// Files smaller than this are parsed by a single thread
+static const size_t min_bytes_per_thread = 1 << 20;
+
+// Shortest text of a point "x y t" and of a record header "label length", each with a separator.
+// Amounts read from a file are checked against the bytes left before anything is allocated for them
+static const size_t min_point_bytes = 6;
+static const size_t min_record_bytes = 4;
+static const size_t min_cut_point_bytes = 2; // also the shortest partition record "size"
+
+// The last item may have no separator
+static bool fits(size_t amount, size_t min_item_bytes, const dat_scanner_t & scanner)
+{
+	return amount <= (scanner.remaining() + 1) / min_item_bytes;
+}
+
+static bool scan_header(dat_scanner_t & scanner, int & video_length, int & amount_of_elements)
+{
+	return scanner.next(video_length) && scanner.next(amount_of_elements) && amount_of_elements >= 0;
+}
+
+// Parses points of i-th trajectory, which is already allocated in the store. Its length is known
+static bool scan_points(dat_scanner_t & scanner, size_t i, trajectory_store_t & trajectories)
+{
+	trajectory_store_t::component_t * x = trajectories._x.data() + trajectories._offsets[i];
+	trajectory_store_t::component_t * y = trajectories._y.data() + trajectories._offsets[i];
+
+	double point_x, point_y;
+	int frame;
+	for(size_t j=0; j<trajectories.length(i); ++j) {
+		if( !scanner.next(point_x) || !scanner.next(point_y) || !scanner.next(frame) ) {
+			return false;
+		}
+		x[j] = point_x;
+		y[j] = point_y;
+		if(j == 0) {
+			trajectories._start_frames[i] = frame;
+		}
+	}
+	return true;
+}
+
+// Parses trajectories [first, last) of a preallocated store starting from the current position of the scanner
+static bool scan_range(dat_scanner_t & scanner, size_t first, size_t last, trajectory_store_t & trajectories, std::vector<int> * labels)
+{
+	for(size_t i=first; i<last; ++i) {
+		int label;
+		size_t size;
+		if( !scanner.next(label) || !scanner.next(size) || size != trajectories.length(i) ) {
+			return false;
+		}
+		if( !scan_points(scanner, i, trajectories) ) {
+			return false;
+		}
+		if(labels != 0) {
+			(*labels)[i] = label;
+		}
+	}
+	return true;
+}
+
+// Parses trajectories one after another, growing the store
+static bool scan_sequential(dat_scanner_t & scanner, size_t amount, trajectory_store_t & trajectories, std::vector<int> * labels)
+{
+	trajectories.clear();
+	for(size_t i=0; i<amount; ++i) {
+		int label;
+		size_t size;
+		if( !scanner.next(label) || !scanner.next(size) || !fits(size, min_point_bytes, scanner) ) {
+			return false;
+		}
+		trajectories.append(size, 0);
+		if( !scan_points(scanner, i, trajectories) ) {
+			return false;
+		}
+		if(labels != 0) {
+			(*labels)[i] = label;
+		}
+	}
+	return true;
+}
+
+// Finds the beginning and the length of every '<label> <length>' record, relying on one point per line.
+// Returns false if the file does not follow this layout
+static bool find_records(dat_scanner_t & scanner, size_t amount, std::vector<const char*> & records, std::vector<size_t> & lengths)
+{
+	records.resize(amount);
+	lengths.resize(amount);
+	for(size_t i=0; i<amount; ++i) {
+		scanner.skip_spaces();
+		records[i] = scanner.position();
+
+		int label;
+		if( !scanner.next(label) || !scanner.next(lengths[i]) ) {
+			return false;
+		}
+		if( !scanner.skip_line() || !scanner.skip_lines(lengths[i]) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Two phases: records are located by a fast line-skipping pass, which gives the exact size of the store,
+// then contiguous ranges of records of roughly equal size in bytes are parsed concurrently.
+// If either phase fails, the file is parsed again by scan_sequential()
+static bool scan_parallel(dat_scanner_t & scanner, size_t amount, unsigned int num_threads,
+		trajectory_store_t & trajectories, std::vector<int> * labels)
+{
+	const char * records_begin = scanner.position();
+
+	std::vector<const char*> records;
+	std::vector<size_t> lengths;
+	if( !find_records(scanner, amount, records, lengths) ) {
+		scanner.seek(records_begin);
+		return scan_sequential(scanner, amount, trajectories, labels);
+	}
+	const char * records_end = scanner.position();
+	trajectories.recreate(lengths);
+
+	if(num_threads <= 1) {
+		scanner.seek(records_begin);
+		if( scan_range(scanner, 0, amount, trajectories, labels) ) {
+			return true;
+		}
+		scanner.seek(records_begin);
+		return scan_sequential(scanner, amount, trajectories, labels);
+	}
+
+	std::vector<size_t> range_begin(num_threads+1);
+	range_begin[0] = 0;
+	size_t bytes_per_thread = (records_end - records_begin) / num_threads;
+	for(unsigned int t=1; t<num_threads; ++t) {
+		size_t i = range_begin[t-1];
+		while(i < amount && (size_t)(records[i] - records_begin) < t*bytes_per_thread) {
+			++i;
+		}
+		range_begin[t] = i;
+	}
+	range_begin[num_threads] = amount;
+
+	std::vector<char> is_ok(num_threads, false);
+	std::vector<std::thread> workers;
+	for(unsigned int t=0; t<num_threads; ++t) {
+		workers.push_back(std::thread([&, t]() {
+			size_t first = range_begin[t];
+			size_t last = range_begin[t+1];
+			if(first == last) {
+				is_ok[t] = true;
+				return;
+			}
+			dat_scanner_t range_scanner(records[first], (last < amount)? records[last]: records_end);
+			is_ok[t] = scan_range(range_scanner, first, last, trajectories, labels);
+		}));
+	}
+	bool is_loaded = true;
+	for(unsigned int t=0; t<num_threads; ++t) {
+		workers[t].join();
+		is_loaded = is_loaded && is_ok[t];
+	}
+	if( !is_loaded ) {
+		// find_records() can locate wrong records in a file with several points on a line without failing itself.
+		// The sequential scan does not depend on lines, so it decides whether the file is malformed
+		scanner.seek(records_begin);
+		return scan_sequential(scanner, amount, trajectories, labels);
+	}
+	return true;
+}
+
+static bool load_trajectories(const std::string & path, int & video_length, trajectory_store_t & trajectories, std::vector<int> * labels)
+{
+	mapped_file_t file;
+	if( !file.open(path) ) {
+		return false;
+	}
+	dat_scanner_t scanner(file.data(), file.end());
+
+	int amount;
+	if( !scan_header(scanner, video_length, amount) || !fits(amount, min_record_bytes, scanner) ) {
+		return false;
+	}
+	if(labels != 0) {
+		labels->resize(amount);
+	}
+
+	unsigned int num_threads = std::thread::hardware_concurrency();
+	if(num_threads > file.size()/min_bytes_per_thread) {
+		num_threads = file.size()/min_bytes_per_thread;
+	}
+	return scan_parallel(scanner, amount, num_threads, trajectories, labels);
+}
+
+bool load_trajectories(const std::string & path, int & video_length, trajectory_store_t & trajectories)
+{
+	return load_trajectories(path, video_length, trajectories, 0);
+}
+
+bool load_trajectories(const std::string & path, int & video_length, trajectory_store_t & trajectories, std::vector<int> & labels)
+{
+	return load_trajectories(path, video_length, trajectories, &labels);
+}
+
+bool load_partitions(const std::string & path, int & video_length, partition_store_t & partitions)
+{
+	mapped_file_t file;
+	if( !file.open(path) ) {
+		return false;
+	}
+	dat_scanner_t scanner(file.data(), file.end());
+
+	int amount;
+	if( !scan_header(scanner, video_length, amount) || !fits(amount, min_cut_point_bytes, scanner) ) {
+		return false;
+	}
+
+	// Cut points are appended to one array, so it takes a logarithmic amount of allocations
+	partitions.clear();
+	partitions._offsets.reserve(amount+1);
+	for(int i=0; i<amount; ++i) {
+		size_t size;
+		if( !scanner.next(size) || !fits(size, min_cut_point_bytes, scanner) ) {
+			return false;
+		}
+		size_t first = partitions._cut_points.size();
+		partitions.append(size);
+		for(size_t j=first; j<first+size; ++j) {
+			if( !scanner.next(partitions._cut_points[j]) ) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "trajectory_store.hpp"
+
+// Loaders of whole .dat files. A file is memory-mapped and parsed in place by dat_scanner_t,
+// so they are much faster than a sequence of read() calls on std::ifstream.
+// Large files are split into ranges of records that are parsed by all available cores.
+// Return false if a file cannot be opened or is malformed.
+
+bool load_trajectories(const std::string & path, int & video_length, trajectory_store_t & trajectories);
+// Keeps trajectory labels as well. They are not used by the viewer, but some tools need them
+bool load_trajectories(const std::string & path, int & video_length, trajectory_store_t & trajectories, std::vector<int> & labels);
+
+// Cut points are not checked against trajectories, see partition_store_t::fits()
+bool load_partitions(const std::string & path, int & video_length, partition_store_t & partitions);
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // memchr
+#include <sstream>
+#include <string>
+
+// Whitespace separated number scanner over a character range (e.g. a memory-mapped .dat file).
+// Reads the same tokens as operator>> of std::istream, but without locale and stream overhead.
+class dat_scanner_t
+{
+	public:
+	dat_scanner_t(const char * begin, const char * end): _pos(begin), _end(end) { }
+
+	const char * position() const { return _pos; }
+	void seek(const char * pos) { _pos = pos; }
+	bool eof() const { return _pos == _end; }
+	size_t remaining() const { return _end - _pos; } // bytes left
+
+	// Each function returns false if there is no token or it is not a number
+	bool next(int & value);
+	bool next(size_t & value);
+	bool next(double & value);
+
+	void skip_spaces();
+	// Moves to the first character after the next '\n'. Returns false at the end of input
+	bool skip_line();
+	// Skips n lines at memchr speed. Returns false if the input ends earlier
+	bool skip_lines(size_t n);
+
+	private:
+	bool next_integer(bool allow_sign, bool & negative, uint64_t & value);
+	bool next_double_slow(const char * begin, double & value);
+
+	const char * _pos;
+	const char * _end;
+}; // dat_scanner_t
+
+inline void dat_scanner_t::skip_spaces()
+{
+	while(_pos != _end && (*_pos == ' ' || *_pos == '\n' || *_pos == '\r' || *_pos == '\t' || *_pos == '\v' || *_pos == '\f')) {
+		++_pos;
+	}
+}
+
+inline bool dat_scanner_t::skip_line()
+{
+	while(_pos != _end && *_pos != '\n') {
+		++_pos;
+	}
+	if(_pos == _end) {
+		return false;
+	}
+	++_pos;
+	return true;
+}
+
+inline bool dat_scanner_t::skip_lines(size_t n)
+{
+	for(size_t i=0; i<n; ++i) {
+		const char * eol = (const char*)memchr(_pos, '\n', _end - _pos);
+		if(eol == 0) {
+			_pos = _end;
+			return i+1 == n; // the last line may have no '\n'
+		}
+		_pos = eol + 1;
+	}
+	return true;
+}
+
+inline bool dat_scanner_t::next_integer(bool allow_sign, bool & negative, uint64_t & value)
+{
+	skip_spaces();
+	negative = false;
+	if(_pos != _end && (*_pos == '-' || *_pos == '+')) {
+		if(!allow_sign) {
+			return false;
+		}
+		negative = *_pos++ == '-';
+	}
+	const char * digits = _pos;
+	value = 0;
+	while(_pos != _end && (unsigned)(*_pos - '0') < 10) {
+		value = value*10 + (*_pos++ - '0');
+	}
+	return _pos != digits;
+}
+
+inline bool dat_scanner_t::next(int & value)
+{
+	bool negative;
+	uint64_t u;
+	if( !next_integer(true, negative, u) ) {
+		return false;
+	}
+	value = negative? -(int)u: (int)u;
+	return true;
+}
+
+inline bool dat_scanner_t::next(size_t & value)
+{
+	bool negative;
+	uint64_t u;
+	if( !next_integer(false, negative, u) ) {
+		return false;
+	}
+	value = u;
+	return true;
+}
+
+inline bool dat_scanner_t::next(double & value)
+{
+	// Powers of ten that are exact in double
+	static const double exact_pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	skip_spaces();
+	const char * begin = _pos;
+
+	bool negative = false;
+	if(_pos != _end && (*_pos == '-' || *_pos == '+')) {
+		negative = *_pos++ == '-';
+	}
+
+	uint64_t mantissa = 0;
+	int num_digits = 0; // significant digits accumulated in mantissa
+	int exponent = 0;
+	bool has_digits = false;
+	for(; _pos != _end && (unsigned)(*_pos - '0') < 10; ++_pos) {
+		has_digits = true;
+		if(mantissa == 0 && *_pos == '0') {
+			continue;
+		}
+		if(num_digits < 19) {
+			mantissa = mantissa*10 + (*_pos - '0');
+			++num_digits;
+		} else {
+			++exponent;
+		}
+	}
+	if(_pos != _end && *_pos == '.') {
+		++_pos;
+		for(; _pos != _end && (unsigned)(*_pos - '0') < 10; ++_pos) {
+			has_digits = true;
+			if(mantissa == 0 && *_pos == '0') {
+				--exponent;
+				continue;
+			}
+			if(num_digits < 19) {
+				mantissa = mantissa*10 + (*_pos - '0');
+				++num_digits;
+				--exponent;
+			}
+		}
+	}
+	if(!has_digits) {
+		_pos = begin;
+		return false;
+	}
+	if(_pos != _end && (*_pos == 'e' || *_pos == 'E')) {
+		const char * e = _pos++;
+		bool negative_e = false;
+		if(_pos != _end && (*_pos == '-' || *_pos == '+')) {
+			negative_e = *_pos++ == '-';
+		}
+		if(_pos == _end || (unsigned)(*_pos - '0') >= 10) {
+			_pos = e; // not an exponent, operator>> would stop here as well
+		} else {
+			int e_value = 0;
+			for(; _pos != _end && (unsigned)(*_pos - '0') < 10; ++_pos) {
+				if(e_value < 100000) {
+					e_value = e_value*10 + (*_pos - '0');
+				}
+			}
+			exponent += negative_e? -e_value: e_value;
+		}
+	}
+
+	// Fast path: mantissa and power of ten are exact, so one multiplication or division is correctly rounded
+	if(mantissa < (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+		double d = (double)mantissa;
+		d = (exponent < 0)? d/exact_pow10[-exponent]: d*exact_pow10[exponent];
+		value = negative? -d: d;
+		return true;
+	}
+	return next_double_slow(begin, value);
+}
+
+inline bool dat_scanner_t::next_double_slow(const char * begin, double & value)
+{
+	// Rare: long mantissas or huge exponents are left to the standard library
+	std::istringstream in(std::string(begin, _pos));
+	in >> value;
+	return !in.fail();
+}
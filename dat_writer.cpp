@@ -0,0 +1,119 @@
+#include "dat_writer.hpp"
+#include <cassert>
+#include <cmath> // lroundf
+
+void write_dat_header(int video_length, int amount_of_elements, block_writer_t & out)
+{
+	assert(out.is_open());
+	out.put(video_length);
+	out.put('\n');
+	out.put(amount_of_elements);
+	out.put('\n');
+}
+
+// The first point is rounded to integers, as write() with std::ofstream does.
+// point(i) returns i-th point of a trajectory. A trajectory without points is written as a record of length 0,
+// which the readers accept; its start frame is lost
+template<typename Point>
+static void write_points(Point point, size_t size, unsigned int start_frame, int label, block_writer_t & out)
+{
+	assert(out.is_open());
+
+	out.put(label);
+	out.put(' ');
+	out.put((unsigned long)size);
+	out.put('\n');
+	if(size == 0) {
+		return;
+	}
+
+	unsigned int frame = start_frame;
+	trajectory_t::point_t p = point(0);
+	out.put(lroundf(p.x));
+	out.put(' ');
+	out.put(lroundf(p.y));
+	out.put(' ');
+	out.put(frame++);
+	out.put('\n');
+	for(size_t i=1; i<size; ++i) {
+		p = point(i);
+		out.put((double)p.x);
+		out.put(' ');
+		out.put((double)p.y);
+		out.put(' ');
+		out.put(frame++);
+		out.put('\n');
+	}
+}
+
+void write(const trajectory_t & tr, block_writer_t & out)
+{
+	write_points([&](size_t j) { return tr[j]; }, tr.size(), tr._start_frame, 0/*label*/, out);
+}
+
+void write(const trajectory_store_t & trajectories, size_t i, block_writer_t & out)
+{
+	write(trajectories, i, 0/*label*/, out);
+}
+
+void write(const trajectory_store_t & trajectories, size_t i, int label, block_writer_t & out)
+{
+	write_points([&](size_t j) { return trajectories.point(i, j); }, trajectories.length(i), trajectories.start_frame(i), label, out);
+}
+
+template<typename Partition>
+static void write_cut_points(const Partition & pr, block_writer_t & out)
+{
+	assert(out.is_open());
+
+	out.put((unsigned long)pr.size());
+	out.put('\n');
+	for(typename Partition::const_iterator cit=pr.begin(); cit!=pr.end(); ++cit) {
+		out.put((unsigned long)*cit);
+		out.put(' ');
+	}
+	out.put('\n');
+}
+
+void write(const partition_t & pr, block_writer_t & out)
+{
+	write_cut_points(pr, out);
+}
+
+void write(const partition_store_t::cut_points_t & pr, block_writer_t & out)
+{
+	write_cut_points(pr, out);
+}
+
+bool save_trajectories(const std::string & path, int video_length, const trajectory_store_t & trajectories)
+{
+	return save_trajectories(path, video_length, trajectories, std::vector<int>());
+}
+
+bool save_trajectories(const std::string & path, int video_length, const trajectory_store_t & trajectories, const std::vector<int> & labels)
+{
+	assert(labels.empty() || labels.size() == trajectories.size());
+
+	block_writer_t out;
+	if( !out.open(path) ) {
+		return false;
+	}
+	write_dat_header(video_length, trajectories.size(), out);
+	for(size_t i=0; i<trajectories.size(); ++i) {
+		write(trajectories, i, labels.empty()? 0: labels[i], out);
+	}
+	return out.close();
+}
+
+bool save_partitions(const std::string & path, int video_length, const partition_store_t & partitions)
+{
+	block_writer_t out;
+	if( !out.open(path) ) {
+		return false;
+	}
+	write_dat_header(video_length, partitions.size(), out);
+	for(size_t i=0; i<partitions.size(); ++i) {
+		write(partitions[i], out);
+	}
+	return out.close();
+}
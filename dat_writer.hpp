@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "trajectory_t.hpp"
+#include "trajectory_store.hpp"
+#include "block_writer.hpp"
+
+// Writers of .dat files through block_writer_t. The text is the same as of write() with std::ofstream,
+// but it is formatted in a large buffer and written in big blocks
+
+void write_dat_header(int video_length, int amount_of_elements, block_writer_t & out);
+
+void write(const trajectory_t & tr, block_writer_t & out);
+void write(const trajectory_store_t & trajectories, size_t i, block_writer_t & out); // label is 0
+void write(const trajectory_store_t & trajectories, size_t i, int label, block_writer_t & out);
+
+void write(const partition_t & pr, block_writer_t & out);
+void write(const partition_store_t::cut_points_t & pr, block_writer_t & out);
+
+// Return false if a file cannot be written
+bool save_trajectories(const std::string & path, int video_length, const trajectory_store_t & trajectories);
+// labels may be empty, then all labels are written as 0
+bool save_trajectories(const std::string & path, int video_length, const trajectory_store_t & trajectories, const std::vector<int> & labels);
+bool save_partitions(const std::string & path, int video_length, const partition_store_t & partitions);
@@ -6,16 +6,23 @@ bool convolve(const std::vector<double> & f, const std::vector<double> & kernel,
 	if( &f == &out ) {
 		return false;
 	}
-	if( f.size() < kernel.size() ) {
+	return convolve(f.data(), f.size(), kernel, out);
+}
+bool convolve(const double * f, size_t size, const std::vector<double> & kernel, std::vector<double> & out)
+{
+	if( !out.empty() && f == out.data() ) {
+		return false;
+	}
+	if( size < kernel.size() ) {
 		return false;
 	}
 
-	out.resize(f.size());
+	out.resize(size);
 
 	size_t l_half = floor(kernel.size()/2); // amount of elements on the left
 	size_t r_half = kernel.size() - 1 - l_half; // amount of elements on the right
 
-	for(size_t i = l_half; i < f.size()-r_half; ++i) {
+	for(size_t i = l_half; i < size-r_half; ++i) {
 		double sum = 0;
 		for( size_t j=0; j<kernel.size(); ++j) {
 			sum += f[i + j-l_half]*kernel[j];
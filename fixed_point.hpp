@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cmath> // lround
+#include <limits>
+#include <istream>
+#include <ostream>
+
+// Signed fixed point number: Int keeps the value multiplied by 2^FracBits.
+// It is encoded on assignment and decoded to double on access, so it can replace double in storage.
+// Values out of the range of Int are saturated
+template<typename Int, int FracBits>
+class fixed_point_t
+{
+	public:
+	fixed_point_t(): _value(0) { }
+	fixed_point_t(double value): _value(encode(value)) { }
+
+	operator double() const { return _value / scale(); }
+
+	Int raw() const { return _value; }
+
+	static double scale() { return double(1 << FracBits); }
+	static double resolution() { return 1.0 / scale(); }
+
+	private:
+	static Int encode(double value)
+	{
+		double scaled = value * scale();
+		if(scaled <= std::numeric_limits<Int>::min()) {
+			return std::numeric_limits<Int>::min();
+		}
+		if(scaled >= std::numeric_limits<Int>::max()) {
+			return std::numeric_limits<Int>::max();
+		}
+		return (Int)lround(scaled);
+	}
+
+	Int _value;
+}; // fixed_point_t
+
+template<typename Int, int FracBits>
+std::istream & operator>>(std::istream & in, fixed_point_t<Int, FracBits> & value)
+{
+	double d;
+	if(in >> d) {
+		value = d;
+	}
+	return in;
+}
+
+template<typename Int, int FracBits>
+std::ostream & operator<<(std::ostream & out, const fixed_point_t<Int, FracBits> & value)
+{
+	return out << (double)value;
+}
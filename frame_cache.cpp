@@ -0,0 +1,153 @@
+#include "frame_cache.hpp"
+
+#include <algorithm> // min
+#include <cassert>
+
+static size_t bytes_of(const cv::Mat & frame)
+{
+	return frame.total() * frame.elemSize();
+}
+
+frame_cache_t::frame_cache_t(size_t amount_of_frames, const loader_t & loader, size_t budget, size_t prefetch_depth):
+	_loader(loader), _budget(budget), _prefetch_depth(prefetch_depth), _slots(amount_of_frames), _memory(0),
+	_prefetch_frame(0), _prefetch_direction(0), _has_prefetch_request(false), _is_stopped(false)
+{
+	_prefetcher = std::thread(&frame_cache_t::prefetch_loop, this);
+}
+
+frame_cache_t::~frame_cache_t()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_is_stopped = true;
+	}
+	_requested.notify_one();
+	_prefetcher.join();
+}
+
+cv::Mat frame_cache_t::get(size_t frame_id)
+{
+	assert(frame_id < _slots.size());
+	std::unique_lock<std::mutex> lock(_mutex);
+	slot_t & slot = _slots[frame_id];
+	while(slot._is_loading) { // the prefetcher is decoding it
+		_loaded.wait(lock);
+	}
+	if(slot._is_cached) {
+		touch(frame_id);
+		return slot._frame;
+	}
+
+	slot._is_loading = true;
+	lock.unlock();
+	cv::Mat frame = _loader(frame_id);
+	lock.lock();
+	slot._is_loading = false;
+	if( !frame.empty() ) {
+		insert(frame_id, frame);
+	}
+	_loaded.notify_all();
+	return frame;
+}
+
+void frame_cache_t::prefetch(size_t frame_id, int direction)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_prefetch_frame = frame_id;
+		_prefetch_direction = (direction < 0)? -1: 1;
+		_has_prefetch_request = true;
+	}
+	_requested.notify_one();
+}
+
+void frame_cache_t::clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	for(size_t frame_id : _lru) {
+		_slots[frame_id]._frame.release();
+		_slots[frame_id]._is_cached = false;
+	}
+	_lru.clear();
+	_memory = 0;
+}
+
+size_t frame_cache_t::memory() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _memory;
+}
+
+void frame_cache_t::touch(size_t frame_id)
+{
+	_lru.splice(_lru.begin(), _lru, _slots[frame_id]._lru_position);
+}
+
+void frame_cache_t::insert(size_t frame_id, const cv::Mat & frame)
+{
+	slot_t & slot = _slots[frame_id];
+	slot._frame = frame;
+	slot._is_cached = true;
+	_lru.push_front(frame_id);
+	slot._lru_position = _lru.begin();
+	_memory += bytes_of(frame);
+
+	// the inserted frame is never evicted, even if it alone exceeds the budget
+	while(_memory > _budget && _lru.size() > 1) {
+		slot_t & evicted = _slots[_lru.back()];
+		_memory -= bytes_of(evicted._frame);
+		evicted._frame.release();
+		evicted._is_cached = false;
+		_lru.pop_back();
+	}
+}
+
+void frame_cache_t::prefetch_loop()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	for(;;) {
+		while( !_is_stopped && !_has_prefetch_request ) {
+			_requested.wait(lock);
+		}
+		if(_is_stopped) {
+			return;
+		}
+		_has_prefetch_request = false;
+		size_t frame_id = _prefetch_frame;
+		int direction = _prefetch_direction;
+
+		// prefetched frames must not evict each other or the shown frame, so at most half of the budget is prefetched
+		size_t depth = _prefetch_depth;
+		if(_slots[frame_id]._is_cached) {
+			size_t frame_size = bytes_of(_slots[frame_id]._frame);
+			if(frame_size > 0) {
+				depth = std::min(depth, _budget / frame_size / 2);
+			}
+		}
+
+		for(size_t k=1; k<=depth && !_is_stopped && !_has_prefetch_request; ++k) {
+			if( (direction < 0 && frame_id < k) || (direction > 0 && frame_id + k >= _slots.size()) ) {
+				break;
+			}
+			size_t next_frame_id = (direction < 0)? frame_id - k: frame_id + k;
+			slot_t & slot = _slots[next_frame_id];
+			if(slot._is_loading) {
+				continue;
+			}
+			if(slot._is_cached) {
+				touch(next_frame_id);
+				continue;
+			}
+
+			slot._is_loading = true;
+			lock.unlock();
+			cv::Mat frame = _loader(next_frame_id);
+			lock.lock();
+			slot._is_loading = false;
+			if( !frame.empty() ) {
+				insert(next_frame_id, frame);
+			}
+			_loaded.notify_all();
+		}
+	}
+}
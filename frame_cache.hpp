@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <opencv2/core/core.hpp>
+
+// Keeps recently used frames of a video within a budget of bytes, other frames are decoded on demand.
+// A background thread decodes frames following the last shown frame in the direction of navigation
+class frame_cache_t
+{
+	public:
+	typedef std::function<cv::Mat(size_t)> loader_t; // decodes a frame by its index, returns an empty matrix on failure
+
+	frame_cache_t(size_t amount_of_frames, const loader_t & loader, size_t budget, size_t prefetch_depth = 8);
+	~frame_cache_t();
+
+	frame_cache_t(const frame_cache_t &) = delete;
+	frame_cache_t & operator=(const frame_cache_t &) = delete;
+
+	// The returned matrix shares data with the cache and stays valid when the frame is evicted. It is empty on failure
+	cv::Mat get(size_t frame_id);
+	// Asks to decode frames after (direction > 0) or before (direction < 0) the frame. A new request cancels the previous one
+	void prefetch(size_t frame_id, int direction);
+	// Drops all frames, e.g. when the loader would return other frames now
+	void clear();
+
+	size_t size() const { return _slots.size(); }
+	size_t memory() const; // bytes taken by cached frames
+
+	private:
+	struct slot_t
+	{
+		slot_t(): _is_cached(false), _is_loading(false) { }
+
+		cv::Mat _frame;
+		bool _is_cached;
+		bool _is_loading;
+		std::list<size_t>::iterator _lru_position;
+	}; // slot_t
+
+	// _mutex must be locked
+	void touch(size_t frame_id);
+	void insert(size_t frame_id, const cv::Mat & frame);
+	void prefetch_loop();
+
+	loader_t _loader;
+	size_t _budget;
+	size_t _prefetch_depth;
+
+	std::vector<slot_t> _slots;
+	std::list<size_t> _lru; // ids of cached frames, the most recently used is the first
+	size_t _memory;
+
+	mutable std::mutex _mutex;
+	std::condition_variable _loaded; // a frame is decoded
+	std::condition_variable _requested; // a prefetch is requested or the cache is being destroyed
+	size_t _prefetch_frame;
+	int _prefetch_direction;
+	bool _has_prefetch_request;
+	bool _is_stopped;
+	std::thread _prefetcher;
+}; // frame_cache_t
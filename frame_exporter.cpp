@@ -0,0 +1,195 @@
+#include "frame_exporter.hpp"
+
+#include <algorithm> // max
+#include <cstdlib> // atoi atof
+#include <exception>
+
+bool parse_export_format(const std::string & text, export_format_t & format)
+{
+	size_t separator = text.find(':');
+	std::string type = text.substr(0, separator);
+	bool has_parameter = separator != std::string::npos;
+	std::string parameter = has_parameter? text.substr(separator+1): std::string();
+
+	format = export_format_t();
+	if(type == "jpg" || type == "jpeg") {
+		format._type = export_format_t::jpeg;
+		if(has_parameter) {
+			format._quality = atoi(parameter.c_str());
+		}
+		return 0 <= format._quality && format._quality <= 100;
+	}
+	if(type == "png") {
+		format._type = export_format_t::png;
+		format._quality = 3;
+		if(has_parameter) {
+			format._quality = atoi(parameter.c_str());
+		}
+		return 0 <= format._quality && format._quality <= 9;
+	}
+	if(type == "avi") {
+		format._type = export_format_t::video;
+		if(has_parameter) {
+			format._fps = atof(parameter.c_str());
+		}
+		return format._fps > 0;
+	}
+	return false;
+}
+
+frame_exporter_t::~frame_exporter_t()
+{
+	close();
+}
+
+bool frame_exporter_t::start(const std::string & path_prefix, const export_format_t & format, size_t amount_of_frames, cv::Size frame_size)
+{
+	if( is_running() ) {
+		return false;
+	}
+	close();
+
+	_path_prefix = path_prefix;
+	_format = format;
+	if(_format._type == export_format_t::video) {
+		if( !_video.open(path_prefix + ".avi", CV_FOURCC('M','J','P','G'), _format._fps, frame_size) ) {
+			return false;
+		}
+	}
+
+	_queue.clear();
+	_amount = amount_of_frames;
+	_amount_of_written = 0;
+	_amount_of_failed = 0;
+	_first_error.clear();
+	_is_closed = false;
+
+	if(_format._type == export_format_t::video) {
+		_writers.push_back(std::thread(&frame_exporter_t::write_video, this));
+	} else {
+		unsigned int num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+		for(unsigned int t=0; t<num_threads; ++t) {
+			_writers.push_back(std::thread(&frame_exporter_t::write_images, this));
+		}
+	}
+	return true;
+}
+
+void frame_exporter_t::push(size_t frame_id, const cv::Mat & frame)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while(_queue.size() >= _capacity) {
+		_not_full.wait(lock);
+	}
+	_queue.push_back(std::make_pair(frame_id, frame));
+	_not_empty.notify_one();
+}
+
+size_t frame_exporter_t::free_space() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _capacity - _queue.size();
+}
+
+bool frame_exporter_t::is_running() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return !_is_closed && _amount_of_written < _amount;
+}
+
+size_t frame_exporter_t::amount_of_written() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _amount_of_written;
+}
+
+size_t frame_exporter_t::amount_of_failed() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _amount_of_failed;
+}
+
+std::string frame_exporter_t::first_error() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _first_error;
+}
+
+void frame_exporter_t::close()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_is_closed = true;
+	}
+	_not_empty.notify_all();
+	for(std::thread & writer : _writers) {
+		writer.join();
+	}
+	_writers.clear();
+	_video.release();
+}
+
+bool frame_exporter_t::pop(std::pair<size_t, cv::Mat> & item)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while(_queue.empty() && !_is_closed) {
+		_not_empty.wait(lock);
+	}
+	if(_queue.empty()) {
+		return false;
+	}
+	item = _queue.front();
+	_queue.pop_front();
+	_not_full.notify_one();
+	return true;
+}
+
+void frame_exporter_t::write_images()
+{
+	std::vector<int> parameters;
+	std::string extension;
+	if(_format._type == export_format_t::jpeg) {
+		parameters.push_back(CV_IMWRITE_JPEG_QUALITY);
+		extension = ".jpg";
+	} else {
+		parameters.push_back(CV_IMWRITE_PNG_COMPRESSION);
+		extension = ".png";
+	}
+	parameters.push_back(_format._quality);
+
+	std::pair<size_t, cv::Mat> item;
+	while( pop(item) ) {
+		std::string str_id = std::to_string(item.first);
+		str_id = std::string(str_id.length() < 4? 4 - str_id.length(): 0, '0') + str_id;
+		std::string path = _path_prefix + str_id + extension;
+		// an exception must not leave the thread, it would terminate the program
+		try {
+			count_written(cv::imwrite(path, item.second, parameters), std::string());
+		} catch(const std::exception & e) {
+			count_written(false, path + ": " + e.what());
+		}
+	}
+}
+
+void frame_exporter_t::write_video()
+{
+	std::pair<size_t, cv::Mat> item;
+	while( pop(item) ) {
+		try {
+			_video.write(item.second); // frames are pushed in order and there is only one writer
+			count_written(true, std::string());
+		} catch(const std::exception & e) {
+			count_written(false, "frame " + std::to_string(item.first) + ": " + e.what());
+		}
+	}
+}
+
+void frame_exporter_t::count_written(bool is_written, const std::string & error)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	++_amount_of_written;
+	_amount_of_failed += is_written? 0: 1;
+	if( _first_error.empty() ) {
+		_first_error = error;
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility> // pair
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+// How exported frames are encoded
+struct export_format_t
+{
+	enum type_t { jpeg, png, video };
+
+	export_format_t(): _type(jpeg), _quality(95), _fps(25) { }
+
+	type_t _type;
+	int _quality; // JPEG quality [0, 100] or PNG compression [0, 9]
+	double _fps; // frame rate of a video
+}; // export_format_t
+
+// Parses "jpg[:<quality>]", "png[:<compression>]" or "avi[:<fps>]"
+bool parse_export_format(const std::string & text, export_format_t & format);
+
+// Encodes and writes frames on background threads, so that a long export does not block the caller.
+// Frames are passed through a bounded queue: images are written by all cores in any order, a video by one thread in order
+class frame_exporter_t
+{
+	public:
+	explicit frame_exporter_t(size_t capacity = 16): _capacity(capacity), _amount(0), _amount_of_written(0), _amount_of_failed(0), _is_closed(true) { }
+	~frame_exporter_t();
+
+	frame_exporter_t(const frame_exporter_t &) = delete;
+	frame_exporter_t & operator=(const frame_exporter_t &) = delete;
+
+	// Images are written to <path_prefix><4-digit frame id>.<extension>, a video to <path_prefix>.avi.
+	// Returns false if an export is running or a video cannot be created
+	bool start(const std::string & path_prefix, const export_format_t & format, size_t amount_of_frames, cv::Size frame_size);
+
+	// Blocks while the queue is full. Frames are not copied, so they must not be changed later
+	void push(size_t frame_id, const cv::Mat & frame);
+	size_t free_space() const; // amount of frames that can be pushed without blocking
+
+	bool is_running() const; // started and not all frames are written
+	size_t amount() const { return _amount; }
+	size_t amount_of_written() const; // including failed ones
+	size_t amount_of_failed() const;
+	// Message of the first exception thrown while a frame was encoded, e.g. by an unsupported frame. Empty if there was none
+	std::string first_error() const;
+
+	// Waits for queued frames and stops threads
+	void close();
+
+	private:
+	void write_images();
+	void write_video();
+	bool pop(std::pair<size_t, cv::Mat> & item); // false if the export is closed and the queue is empty
+	void count_written(bool is_written, const std::string & error);
+
+	size_t _capacity;
+	std::string _path_prefix;
+	export_format_t _format;
+	cv::VideoWriter _video;
+
+	std::deque<std::pair<size_t, cv::Mat> > _queue;
+	size_t _amount;
+	size_t _amount_of_written;
+	size_t _amount_of_failed;
+	std::string _first_error;
+	bool _is_closed;
+
+	mutable std::mutex _mutex;
+	std::condition_variable _not_empty;
+	std::condition_variable _not_full;
+	std::vector<std::thread> _writers;
+}; // frame_exporter_t
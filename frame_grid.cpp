@@ -0,0 +1,152 @@
+#include "frame_grid.hpp"
+#include "trajectory_rasterizer.hpp" // drawn_square
+
+#include <algorithm> // fill lower_bound max
+
+const int frame_grid_t::not_found;
+
+frame_grid_t::frame_grid_t(const frame_index_t & index, int indent, int cell_size):
+	_index(index), _indent(indent), _cell_size(cell_size), _columns(0), _frame_offsets(1, 0), _cell_offsets(1, 0)
+{
+}
+
+void frame_grid_t::build(cv::Size frame_size)
+{
+	clear();
+	_frame_size = frame_size;
+	_columns = (frame_size.width + _cell_size - 1) / _cell_size;
+	append();
+}
+
+void frame_grid_t::append()
+{
+	int rows = (_frame_size.height + _cell_size - 1) / _cell_size;
+	// frames which are not in the grid yet have no points and no cells
+	_frame_points.resize(_index.size(), 0);
+	_frame_offsets.resize(_index.size()+1, _cells.size());
+
+	std::vector<size_t> frame_offsets(1, 0);
+	std::vector<unsigned int> cells;
+	std::vector<size_t> cell_offsets(1, 0);
+	std::vector<unsigned int> entries;
+	cells.reserve(_cells.size());
+	cell_offsets.reserve(_cell_offsets.size());
+	entries.reserve(_entries.size());
+
+	// new points of a frame are bucketed by cells by a counting sort together with the cells the frame has,
+	// then occupied cells are kept. Cells of other frames are copied
+	std::vector<size_t> counts(_columns*rows + 1);
+	std::vector<unsigned int> frame_entries;
+	for(size_t frame_id=0; frame_id<_index.size(); ++frame_id) {
+		frame_index_t::frame_points_t points = _index[frame_id];
+		size_t first_cell = _frame_offsets[frame_id];
+		size_t last_cell = _frame_offsets[frame_id+1];
+		if(points.size() == _frame_points[frame_id]) {
+			for(size_t k=first_cell; k<last_cell; ++k) {
+				cells.push_back(_cells[k]);
+				cell_offsets.push_back(cell_offsets.back() + _cell_offsets[k+1] - _cell_offsets[k]);
+			}
+			entries.insert(entries.end(), _entries.begin() + _cell_offsets[first_cell], _entries.begin() + _cell_offsets[last_cell]);
+			frame_offsets.push_back(cells.size());
+			continue;
+		}
+
+		std::fill(counts.begin(), counts.end(), 0);
+		for(size_t k=first_cell; k<last_cell; ++k) {
+			counts[_cells[k] + 1] += _cell_offsets[k+1] - _cell_offsets[k];
+		}
+		for(size_t point_id=_frame_points[frame_id]; point_id<points.size(); ++point_id) {
+			cv::Point p1, p2;
+			if( !drawn_square(points[point_id], _indent, _frame_size, p1, p2) ) {
+				continue;
+			}
+			for(int row=p1.y/_cell_size; row<=p2.y/_cell_size; ++row)
+			for(int column=p1.x/_cell_size; column<=p2.x/_cell_size; ++column) {
+				++counts[row*_columns + column + 1];
+			}
+		}
+		for(size_t cell=1; cell<counts.size(); ++cell) {
+			counts[cell] += counts[cell-1];
+		}
+
+		frame_entries.resize(counts.back());
+		for(size_t k=first_cell; k<last_cell; ++k) {
+			for(size_t i=_cell_offsets[k]; i<_cell_offsets[k+1]; ++i) {
+				frame_entries[counts[_cells[k]]++] = _entries[i];
+			}
+		}
+		for(size_t point_id=_frame_points[frame_id]; point_id<points.size(); ++point_id) {
+			cv::Point p1, p2;
+			if( !drawn_square(points[point_id], _indent, _frame_size, p1, p2) ) {
+				continue;
+			}
+			for(int row=p1.y/_cell_size; row<=p2.y/_cell_size; ++row)
+			for(int column=p1.x/_cell_size; column<=p2.x/_cell_size; ++column) {
+				frame_entries[counts[row*_columns + column]++] = point_id;
+			}
+		}
+
+		// counts[cell] is the end of the cell now
+		size_t begin = 0;
+		for(size_t cell=0; cell+1<counts.size(); ++cell) {
+			if(counts[cell] == begin) {
+				continue;
+			}
+			cells.push_back(cell);
+			cell_offsets.push_back(cell_offsets.back() + counts[cell] - begin);
+			begin = counts[cell];
+		}
+		entries.insert(entries.end(), frame_entries.begin(), frame_entries.end());
+		frame_offsets.push_back(cells.size());
+		_frame_points[frame_id] = points.size();
+	}
+	_frame_offsets.swap(frame_offsets);
+	_cells.swap(cells);
+	_cell_offsets.swap(cell_offsets);
+	_entries.swap(entries);
+	_cells.shrink_to_fit();
+	_cell_offsets.shrink_to_fit();
+	_entries.shrink_to_fit();
+}
+
+void frame_grid_t::clear()
+{
+	_frame_offsets.assign(1, 0);
+	_cells.clear();
+	_cell_offsets.assign(1, 0);
+	_entries.clear();
+	_frame_points.clear();
+}
+
+int frame_grid_t::find(size_t frame_id, int x, int y) const
+{
+	if(frame_id+1 >= _frame_offsets.size() || x < 0 || y < 0 || x >= _frame_size.width || y >= _frame_size.height) {
+		return not_found;
+	}
+	unsigned int cell = (y/_cell_size)*_columns + x/_cell_size;
+	const unsigned int * frame_begin = _cells.data() + _frame_offsets[frame_id];
+	const unsigned int * frame_end = _cells.data() + _frame_offsets[frame_id+1];
+	const unsigned int * p_cell = std::lower_bound(frame_begin, frame_end, cell);
+	if(p_cell == frame_end || *p_cell != cell) {
+		return not_found;
+	}
+
+	size_t k = p_cell - _cells.data();
+	frame_index_t::frame_points_t points = _index[frame_id];
+	int trajectory_id = not_found;
+	for(size_t i=_cell_offsets[k]; i<_cell_offsets[k+1]; ++i) {
+		const frame_point_t & point = points[_entries[i]];
+		cv::Point p1, p2;
+		drawn_square(point, _indent, _frame_size, p1, p2);
+		if(p1.x <= x && x <= p2.x && p1.y <= y && y <= p2.y) {
+			trajectory_id = std::max<int>(trajectory_id, point._trajectory_id);
+		}
+	}
+	return trajectory_id;
+}
+
+size_t frame_grid_t::memory() const
+{
+	return _frame_offsets.capacity()*sizeof(size_t) + _cells.capacity()*sizeof(unsigned int) +
+		_cell_offsets.capacity()*sizeof(size_t) + _entries.capacity()*sizeof(unsigned int) + _frame_points.capacity()*sizeof(size_t);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "frame_index.hpp"
+
+// Finds the trajectory drawn at a pixel of a frame. Each frame is split into square cells and only occupied cells are kept:
+// cells of frame t are [_frame_offsets[t], _frame_offsets[t+1]) of _cells, sorted, and points whose squares overlap
+// the k-th cell are [_cell_offsets[k], _cell_offsets[k+1]) of _entries. Memory is proportional to the amount of points.
+// Entries are indices of points within their frame, so they stay valid when trajectories are appended to the index
+class frame_grid_t
+{
+	public:
+	static const int not_found = -1;
+
+	// A point covers exactly the pixels the rasterizer paints for it, see drawn_square()
+	frame_grid_t(const frame_index_t & index, int indent, int cell_size = 16);
+
+	// Must be called after the index is rebuilt
+	void build(cv::Size frame_size);
+	// Must be called after trajectories are appended to the index. Only points of frames which gained points are bucketed
+	void append();
+	void clear();
+
+	// Index of the trajectory covering the pixel at the frame, or not_found. If squares of several trajectories cover it,
+	// the trajectory with the greatest index is returned, as it is drawn last
+	int find(size_t frame_id, int x, int y) const;
+
+	size_t memory() const; // bytes taken by the grid
+
+	private:
+	const frame_index_t & _index;
+	int _indent;
+	int _cell_size;
+	cv::Size _frame_size;
+	int _columns; // amount of cells in a row
+
+	std::vector<size_t> _frame_offsets;
+	std::vector<unsigned int> _cells; // row * _columns + column
+	std::vector<size_t> _cell_offsets;
+	std::vector<unsigned int> _entries; // indices of points in _index[frame_id]
+	std::vector<size_t> _frame_points; // amount of points of each frame in the grid
+}; // frame_grid_t
@@ -0,0 +1,82 @@
+#include "frame_index.hpp"
+
+#include <algorithm> // min copy_backward
+#include <cassert>
+
+void frame_index_t::build(const trajectory_store_t & trajectories, const partition_store_t & partitions, size_t last, size_t video_length)
+{
+	_points.clear();
+	_offsets.assign(video_length+1, 0);
+	append(trajectories, partitions, 0, last, video_length);
+}
+
+void frame_index_t::append(const trajectory_store_t & trajectories, const partition_store_t & partitions, size_t first, size_t last, size_t video_length)
+{
+	assert(first <= last && last <= trajectories.size() && last <= partitions.size());
+	assert(size() == video_length);
+
+	// count new points of each frame
+	std::vector<size_t> offsets(video_length+1, 0);
+	for(size_t i=first; i<last; ++i) {
+		size_t first_frame = trajectories.start_frame(i);
+		size_t last_frame = std::min(first_frame + trajectories.length(i), video_length);
+		for(size_t frame_id=first_frame; frame_id<last_frame; ++frame_id) {
+			++offsets[frame_id+1];
+		}
+	}
+	for(size_t frame_id=0; frame_id<video_length; ++frame_id) {
+		offsets[frame_id+1] += offsets[frame_id] + (_offsets[frame_id+1] - _offsets[frame_id]);
+	}
+
+	// move indexed points of each frame to the beginning of its new bucket, from the last frame as buckets only move forward
+	_points.resize(offsets.back());
+	std::vector<size_t> positions(video_length);
+	for(size_t frame_id=video_length; frame_id-- > 0;) {
+		positions[frame_id] = offsets[frame_id] + (_offsets[frame_id+1] - _offsets[frame_id]);
+		std::copy_backward(_points.begin() + _offsets[frame_id], _points.begin() + _offsets[frame_id+1], _points.begin() + positions[frame_id]);
+	}
+	_offsets.swap(offsets);
+
+	// fill buckets
+	for(size_t i=first; i<last; ++i) {
+		trajectory_store_t::components_t x = trajectories.x(i);
+		trajectory_store_t::components_t y = trajectories.y(i);
+		partition_store_t::cut_points_t cut_points = partitions[i];
+		const partition_store_t::cut_point_t * p_cut_point = cut_points.begin();
+		unsigned int segment = 0;
+		size_t frame_id = trajectories.start_frame(i);
+		for(size_t j=0; j<x.size() && frame_id<video_length; ++j, ++frame_id) {
+			frame_point_t & point = _points[positions[frame_id]++];
+			point._trajectory_id = i;
+			point._point_index = j;
+			point._x = x[j];
+			point._y = y[j];
+			point._segment = segment;
+			if( p_cut_point != cut_points.end() && j == *p_cut_point ) {
+				++segment;
+				++p_cut_point;
+			}
+		}
+	}
+}
+
+void frame_index_t::clear()
+{
+	_points.clear();
+	_offsets.assign(1, 0);
+}
+
+size_t frame_index_t::size() const
+{
+	return _offsets.size()-1;
+}
+
+size_t frame_index_t::amount_of_points() const
+{
+	return _offsets.back();
+}
+
+frame_index_t::frame_points_t frame_index_t::operator[](size_t frame_id) const
+{
+	return frame_points_t(_points.data() + _offsets[frame_id], _offsets[frame_id+1] - _offsets[frame_id]);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "trajectory_store.hpp"
+
+// A point of a trajectory at some frame
+struct frame_point_t
+{
+	unsigned int _trajectory_id;
+	unsigned int _point_index; // index of the point in the trajectory
+	trajectory_store_t::component_t _x;
+	trajectory_store_t::component_t _y;
+	unsigned int _segment; // amount of cut points of the trajectory before the point
+}; // frame_point_t
+
+// Points of trajectories bucketed by frames: points of frame t are [_offsets[t], _offsets[t+1]) of _points,
+// ordered by trajectories. Drawing or picking at a frame touches only points existing at the frame
+struct frame_index_t
+{
+	typedef array_view_t<frame_point_t> frame_points_t;
+
+	frame_index_t(): _offsets(1, 0) { }
+
+	// Indexes trajectories [0, last) by a counting sort in two passes over the points.
+	// Points outside of [0, video_length) are not indexed
+	void build(const trajectory_store_t & trajectories, const partition_store_t & partitions, size_t last, size_t video_length);
+	// Indexes trajectories [first, last) in addition to [0, first), which are indexed already (e.g. they were read earlier
+	// from a growing file). Points of a frame stay ordered by trajectories, so the new points go after the indexed ones
+	// and indices of points within frames do not change
+	void append(const trajectory_store_t & trajectories, const partition_store_t & partitions, size_t first, size_t last, size_t video_length);
+	void clear();
+
+	size_t size() const; // amount of frames
+	size_t amount_of_points() const;
+	frame_points_t operator[](size_t frame_id) const;
+
+	std::vector<frame_point_t> _points;
+	std::vector<size_t> _offsets; // size()+1 elements
+}; // frame_index_t
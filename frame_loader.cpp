@@ -0,0 +1,35 @@
+#include "frame_loader.hpp"
+
+#include <algorithm> // min
+#include <atomic>
+#include <thread>
+
+#include <opencv2/highgui/highgui.hpp>
+
+void load_frames(const std::vector<std::string> & paths, std::vector<cv::Mat> & frames, unsigned int num_threads)
+{
+	frames.clear();
+	frames.resize(paths.size());
+
+	if(num_threads == 0) {
+		num_threads = std::thread::hardware_concurrency();
+	}
+	num_threads = std::min<size_t>(std::max(num_threads, 1u), paths.size());
+
+	// frames are taken one by one from a shared counter, since their decoding time may differ a lot
+	std::atomic<size_t> next_frame(0);
+	auto decode = [&]() {
+		for(size_t i = next_frame++; i < paths.size(); i = next_frame++) {
+			frames[i] = cv::imread(paths[i]);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(unsigned int t=1; t<num_threads; ++t) {
+		workers.push_back(std::thread(decode));
+	}
+	decode();
+	for(std::thread & worker : workers) {
+		worker.join();
+	}
+}
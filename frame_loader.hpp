@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+// Decodes frames by all available cores (or num_threads, if it is positive). i-th file is decoded into frames[i],
+// a frame that cannot be read is left empty. Frames are not validated, so the caller checks them in order
+void load_frames(const std::vector<std::string> & paths, std::vector<cv::Mat> & frames, unsigned int num_threads = 0);
@@ -0,0 +1,75 @@
+#include "lifespan_index.hpp"
+
+#include <algorithm> // sort max
+
+void lifespan_index_t::build(const std::vector<lifespan_t> & lifespans)
+{
+	_lifespans = lifespans;
+	std::sort(_lifespans.begin(), _lifespans.end(), [](const lifespan_t & a, const lifespan_t & b) {
+		return a._first_frame < b._first_frame || (a._first_frame == b._first_frame && a._id < b._id);
+	});
+	_max_last_frames.resize(_lifespans.size());
+	build(0, _lifespans.size());
+}
+
+void lifespan_index_t::build(const trajectory_store_t & trajectories, size_t last)
+{
+	std::vector<lifespan_t> lifespans(last);
+	for(size_t i=0; i<last; ++i) {
+		lifespans[i]._first_frame = trajectories.start_frame(i);
+		lifespans[i]._last_frame = trajectories.start_frame(i) + trajectories.length(i);
+		lifespans[i]._id = i;
+	}
+	build(lifespans);
+}
+
+// Returns the greatest last frame of the subtree [first, last)
+unsigned int lifespan_index_t::build(size_t first, size_t last)
+{
+	if(first >= last) {
+		return 0;
+	}
+	size_t middle = first + (last - first)/2;
+	unsigned int max_last_frame = std::max(build(first, middle), build(middle+1, last));
+	_max_last_frames[middle] = std::max(max_last_frame, _lifespans[middle]._last_frame);
+	return _max_last_frames[middle];
+}
+
+void lifespan_index_t::clear()
+{
+	_lifespans.clear();
+	_max_last_frames.clear();
+}
+
+void lifespan_index_t::alive_at(unsigned int frame, std::vector<size_t> & ids) const
+{
+	overlapping(0, _lifespans.size(), frame, frame+1, ids);
+}
+
+void lifespan_index_t::overlapping(unsigned int first_frame, unsigned int last_frame, std::vector<size_t> & ids) const
+{
+	if(first_frame < last_frame) {
+		overlapping(0, _lifespans.size(), first_frame, last_frame, ids);
+	}
+}
+
+void lifespan_index_t::overlapping(size_t first, size_t last, unsigned int first_frame, unsigned int last_frame, std::vector<size_t> & ids) const
+{
+	if(first >= last) {
+		return;
+	}
+	size_t middle = first + (last - first)/2;
+	if(_max_last_frames[middle] <= first_frame) { // the whole subtree ends before the query
+		return;
+	}
+	overlapping(first, middle, first_frame, last_frame, ids);
+
+	const lifespan_t & lifespan = _lifespans[middle];
+	if(lifespan._first_frame >= last_frame) { // so do lifespans of the right subtree
+		return;
+	}
+	if(lifespan._last_frame > first_frame) {
+		ids.push_back(lifespan._id);
+	}
+	overlapping(middle+1, last, first_frame, last_frame, ids);
+}
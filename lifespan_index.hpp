@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "trajectory_store.hpp"
+
+// An interval tree over lifespans of trajectories: which trajectories exist at a frame or in a range of frames.
+// Lifespans are sorted by first frames and form an implicit balanced binary search tree (the root of a range is its middle),
+// each node keeps the greatest last frame of its subtree, so subtrees ending before a query are skipped.
+// A query visits O((k+1) log n) nodes for k results, instead of all n lifespans
+class lifespan_index_t
+{
+	public:
+	struct lifespan_t
+	{
+		unsigned int _first_frame;
+		unsigned int _last_frame; // the frame after the last point
+		size_t _id;
+	}; // lifespan_t
+
+	void build(const std::vector<lifespan_t> & lifespans);
+	// Lifespans of trajectories [0, last), ids are indices in the store
+	void build(const trajectory_store_t & trajectories, size_t last);
+	void clear();
+
+	size_t size() const { return _lifespans.size(); }
+
+	// Appends ids of trajectories existing at the frame
+	void alive_at(unsigned int frame, std::vector<size_t> & ids) const;
+	// Appends ids of trajectories existing in at least one frame of [first_frame, last_frame), ordered by their first frames
+	void overlapping(unsigned int first_frame, unsigned int last_frame, std::vector<size_t> & ids) const;
+
+	private:
+	unsigned int build(size_t first, size_t last);
+	void overlapping(size_t first, size_t last, unsigned int first_frame, unsigned int last_frame, std::vector<size_t> & ids) const;
+
+	std::vector<lifespan_t> _lifespans; // sorted by first frames
+	std::vector<unsigned int> _max_last_frames; // of subtrees
+}; // lifespan_index_t
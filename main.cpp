@@ -4,14 +4,19 @@
 // Show trajectories in the frames and provides x,y projections for each trajectory as well as acceleration
 #include <vector>
 #include <cassert>
-#include <algorithm> // min_element max_element fill_n
+#include <algorithm> // min_element max_element fill_n lower_bound
 
 #include <fstream>
 #include <iostream>
 #include <string>
 
 #include <cstdio> // sprintf
+#include <cstdlib> // atoi exit
 #include <utility> // pair
+#include <memory> // unique_ptr
+#include <chrono>
+#include <thread> // this_thread
+#include <sstream>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
@@ -19,38 +24,69 @@
 
 #include "filters.hpp"
 #include "trajectory_t.hpp"
+#include "trajectory_store.hpp"
+#include "frame_index.hpp"
+#include "frame_grid.hpp"
+#include "trajectory_picker.hpp"
+#include "segment_rtree.hpp"
+#include "trajectory_rasterizer.hpp"
+#include "dat_reader.hpp"
+#include "trajectory_io.hpp"
+#include "dat_follower.hpp"
+#include "trajectory_window.hpp"
+#include "frame_cache.hpp"
+#include "frame_loader.hpp"
+#include "ppm_reader.hpp"
+#include "compressed_sequence.hpp"
+#include "video_reader.hpp"
+#include "frame_exporter.hpp"
 
 extern "C" {
 #include "gnuplot_i.h"
 }
 
-const int not_trajectory_index = -1;
 const int indent = 1; // indent from a point to left, right, top and bottom
+const int follow_interval_ms = 500; // how often growing files are checked in --follow mode
+const int default_video_cache_mb = 512; // frames of a video are always cached, since they cannot be decoded all at once
+const int overlay_cache_mb = 256; // frames with drawn trajectories
+const int compressed_cache_frames = 16; // decoded frames around the current one, when frames are kept compressed
+const int export_batch_size = 16; // frames drawn concurrently while they are exported
+const double default_pick_radius = 5; // a click picks the nearest trajectory within that many pixels
+const int amount_of_nearest = 5; // a click with Ctrl picks that many nearest trajectories
+const int click_tolerance = 2; // the mouse moved by at most that many pixels btw press and release is a click, not a drag
+const cv::Scalar selection_color(0, 255, 255);
 
 // A struct for passing arguments to SetMouseCallback
 class mouse_callback_input_t
 {
 	public:
 	const int & _current_frame_number;
-	const cv::Mat & _pos_2_trajectory_id;
-	const std::vector<trajectory_t> & _trajectories;
-	const std::vector<partition_t> & _partitions;
+	const frame_grid_t & _grid;
+	trajectory_picker_t & _picker;
+	double _pick_radius; // if 0, only a trajectory drawn at the clicked pixel is picked
+	const trajectory_store_t & _trajectories;
+	const partition_store_t & _partitions;
 	const std::vector<cv::Scalar> & _color_scheme;
 
 	cv::Mat _plot_xy;
 	std::string _plot_xy_name;
 
+	std::string _frame_name;
+	cv::Mat _shown_frame; // a selection is drawn over a copy of it while the mouse is dragged
+	bool _is_dragging;
+	std::vector<cv::Point> _lasso; // positions of the mouse since the left button is pressed
+
 	gnuplot_ctrl * _plot_xt[2];
 	gnuplot_ctrl * _plot_yt[2];
 	unsigned int _num_drawn_trajectories;
 
 	public:
-	mouse_callback_input_t( const int & current_frame_number, const cv::Mat & trajectory_id,
-	       			const std::vector<trajectory_t> & trajectories, const std::vector<partition_t> & partitions,
+	mouse_callback_input_t( const int & current_frame_number, const frame_grid_t & grid, trajectory_picker_t & picker, double pick_radius,
+	       			const trajectory_store_t & trajectories, const partition_store_t & partitions,
 				const std::vector<cv::Scalar> & color_scheme):
-			       	_current_frame_number(current_frame_number), _pos_2_trajectory_id(trajectory_id),
+			       	_current_frame_number(current_frame_number), _grid(grid), _picker(picker), _pick_radius(pick_radius),
 			       	_trajectories(trajectories), _partitions(partitions),
-				_color_scheme(color_scheme), _num_drawn_trajectories(0)
+				_color_scheme(color_scheme), _is_dragging(false), _num_drawn_trajectories(0)
 	{
 		for(int i=0; i<2; ++i) {
 			_plot_xt[i] = gnuplot_init();
@@ -74,164 +110,351 @@ class mouse_callback_input_t
 	}
 }; // mouse_callback_input_t
 
-static void show_graphs( int event, int x, int y, int dummy, void * args);
+static void show_graphs( int event, int x, int y, int flags, void * args);
+// Draws xy projections of trajectories and plots their xt, yt projections, speed and acceleration, each plot by one command
+static void plot_trajectories(mouse_callback_input_t * callback_input, const std::vector<unsigned int> & trajectory_ids);
 
 void draw_curve( std::vector<int>::const_iterator x_begin, std::vector<int>::const_iterator x_end,
 		std::vector<int>::const_iterator y_begin, std::vector<int>::const_iterator y_end, const cv::Scalar & color, cv::Mat & out);
 void draw_points( std::vector<int>::const_iterator x_begin, std::vector<int>::const_iterator x_end,
 		std::vector<int>::const_iterator y_begin, std::vector<int>::const_iterator y_end, const cv::Scalar & color, cv::Mat & out);
+// Draws xy projection of a trajectory with given color and its cut points in red
+void draw_xy_projection(trajectory_store_t::components_t x, trajectory_store_t::components_t y, partition_store_t::cut_points_t partition,
+		const cv::Scalar & color, cv::Mat & out);
 
 //// Functions for drawing trajectories in a video sequence with specific color
 // Color correspond to age of trajectory. FIXME what to do if color_scheme has less colors than required?
-void draw_trajectories(const std::vector<trajectory_t> & trajectories, const std::vector<cv::Scalar> & color_scheme, std::vector<cv::Mat> & video);
-// Color correspond to partition of trajectory, color of a partition of trajectory differs form colors of neightbour partitions from the same trajectory
-void draw_trajectories(const std::vector<trajectory_t> & trajectories, const std::vector<partition_t> & partitions, std::vector<cv::Mat> & video);
+void draw_trajectories(const trajectory_store_t & trajectories, const std::vector<cv::Scalar> & color_scheme, std::vector<cv::Mat> & video);
+
+// Parses a comma-separated list of numbers
+bool parse_numbers(const std::string & text, std::vector<double> & numbers);
 
 int main(int argc, char * argv[]) 
 {
 	const cv::Size boundary_size(5,5); // distance btw end of image to drawing area
 
-	if(argc!=1+3) {
-		std::cout << "Usage: " << argv[0] << " <path_to_trajectories> <path_to_partition> <path_to_frames>" << std::endl;
-		return 1;
+	bool is_following = false; // trajectories and partitions are being written, read them as they grow
+	int window_length = 0; // if positive, only trajectories existing in a window of that many frames are kept in memory
+	int cache_budget_mb = 0; // if positive, frames are decoded on demand and at most that many megabytes of them are kept
+	export_format_t export_format; // of frames with trajectories
+	bool is_compressed = false; // frames are kept in memory encoded
+	export_format_t compression_format;
+	double pick_radius = default_pick_radius; // of picking trajectories by a click
+	bool is_headless = false; // frames with trajectories and xy projections are written without showing anything
+	std::vector<size_t> selected_ids; // trajectories whose xy projections are written in headless mode
+	// trajectories passing through a region or crossing a polyline in a range of frames are also selected
+	std::vector<double> region; // x0,y0,x1,y1 of corners
+	std::vector<double> polyline; // x,y of vertices
+	std::vector<double> query_frames; // first,last
+	std::vector<std::string> arguments;
+	for(int i=1; i<argc; ++i) {
+		std::string argument(argv[i]);
+		if(argument == "--follow") {
+			is_following = true;
+		} else if(argument == "--window" && i+1 < argc) {
+			window_length = atoi(argv[++i]);
+			if(window_length <= 0) {
+				std::cout << "Length of a window must be positive" << std::endl;
+				return 1;
+			}
+		} else if(argument == "--cache" && i+1 < argc) {
+			cache_budget_mb = atoi(argv[++i]);
+			if(cache_budget_mb <= 0) {
+				std::cout << "Size of a cache must be positive" << std::endl;
+				return 1;
+			}
+		} else if(argument == "--export" && i+1 < argc) {
+			if( !parse_export_format(argv[++i], export_format) ) {
+				std::cout << "Format of export must be jpg[:<quality>], png[:<compression>] or avi[:<fps>]" << std::endl;
+				return 1;
+			}
+		} else if(argument == "--compress" && i+1 < argc) {
+			is_compressed = true;
+			if( !parse_export_format(argv[++i], compression_format) || compression_format._type == export_format_t::video ) {
+				std::cout << "Format of compression must be jpg[:<quality>] or png[:<compression>]" << std::endl;
+				return 1;
+			}
+		} else if(argument == "--radius" && i+1 < argc) {
+			pick_radius = atof(argv[++i]);
+			if(pick_radius < 0) {
+				std::cout << "Radius of picking must not be negative" << std::endl;
+				return 1;
+			}
+		} else if(argument == "--headless") {
+			is_headless = true;
+		} else if(argument == "--select" && i+1 < argc) {
+			std::stringstream ids(argv[++i]);
+			std::string id;
+			while( std::getline(ids, id, ',') ) {
+				if(id.empty() || id.find_first_not_of("0123456789") != std::string::npos) {
+					std::cout << "Selected trajectories must be a comma-separated list of indices" << std::endl;
+					return 1;
+				}
+				selected_ids.push_back(std::stoul(id));
+			}
+		} else if(argument == "--region" && i+1 < argc) {
+			if( !parse_numbers(argv[++i], region) || region.size() != 4 ) {
+				std::cout << "A region must be given by corners <x0>,<y0>,<x1>,<y1>" << std::endl;
+				return 1;
+			}
+		} else if(argument == "--crossing" && i+1 < argc) {
+			if( !parse_numbers(argv[++i], polyline) || polyline.size() < 4 || polyline.size() % 2 != 0 ) {
+				std::cout << "A polyline must be given by vertices <x0>,<y0>,<x1>,<y1>[,...]" << std::endl;
+				return 1;
+			}
+		} else if(argument == "--frames" && i+1 < argc) {
+			if( !parse_numbers(argv[++i], query_frames) || query_frames.size() != 2 || query_frames[0] < 0 || query_frames[1] < query_frames[0] ) {
+				std::cout << "Frames must be given by <first>,<last>" << std::endl;
+				return 1;
+			}
+		} else {
+			arguments.push_back(argument);
+		}
 	}
 
-	std::string path_to_trajectories(argv[1]);
-	if( path_to_trajectories.compare(path_to_trajectories.find_last_of("."), std::string::npos, ".dat") != 0 ) {
-		std::cout << path_to_trajectories << " must be a .dat file" << std::endl;
+	if(arguments.size()!=3) {
+		std::cout << "Usage: " << argv[0] << " [--follow | --window <frames>] [--cache <megabytes> | --compress <format>] [--export <format>] [--radius <pixels>] [--headless [--select <ids>] [--region <x0,y0,x1,y1>] [--crossing <x0,y0,x1,y1,...>] [--frames <first,last>]] <path_to_trajectories> <path_to_partition> <path_to_frames_or_video>" << std::endl;
 		return 1;
 	}
 
-	std::string path_to_partition(argv[2]);
-	if( path_to_partition.compare(path_to_partition.find_last_of("."), std::string::npos, ".dat") != 0 ) {
-		std::cout << path_to_partition << " must be a .dat file" << std::endl;
+	std::string path_to_trajectories(arguments[0]);
+	if( !is_trajectory_file(path_to_trajectories) ) {
+		std::cout << path_to_trajectories << " must be a .dat, .trb or .trz file" << std::endl;
 		return 1;
 	}
 
-	std::string path_to_list_of_frames(argv[3]);
-	if( path_to_list_of_frames.compare(path_to_list_of_frames.find_last_of("."), std::string::npos, ".bmf") != 0 ) {
-		std::cout << path_to_list_of_frames << " must be a .bmf file" << std::endl;
+	if( is_following && path_to_trajectories.compare(path_to_trajectories.find_last_of("."), std::string::npos, ".dat") != 0 ) {
+		std::cout << "Only .dat trajectories can be followed" << std::endl;
 		return 1;
 	}
 
-	std::string root_dir = path_to_list_of_frames.substr(0, path_to_list_of_frames.find_last_of("/")+1);
-	if(root_dir.compare(path_to_list_of_frames) == 0) { // if frames are in current folder
-		root_dir = "./";
+	if( window_length > 0 && path_to_trajectories.compare(path_to_trajectories.find_last_of("."), std::string::npos, ".dat") != 0 ) {
+		std::cout << "Only .dat trajectories can be loaded by windows" << std::endl;
+		return 1;
 	}
 
-	//// read input
-	// read frames
-	std::ifstream in_frames(path_to_list_of_frames);
-	if( !in_frames.is_open() ) {
-		std::cout << "Cannot " << path_to_list_of_frames << std::endl;
+	if(is_following && window_length > 0) {
+		std::cout << "--follow and --window cannot be used together" << std::endl;
 		return 1;
 	}
 
-	int video_length;
-	int dummy;
-	in_frames >> video_length >> dummy;
+	if(cache_budget_mb > 0 && is_compressed) {
+		std::cout << "--cache and --compress cannot be used together" << std::endl;
+		return 1;
+	}
 
-	std::vector<cv::Mat> frames(video_length);
-	for(size_t i=0; i<frames.size(); ++i) {
-		std::string frame_name;
-		in_frames >> frame_name;
+	if(is_following && is_headless) {
+		std::cout << "--follow and --headless cannot be used together" << std::endl;
+		return 1;
+	}
 
-		frames[i] = cv::imread(root_dir + frame_name);
-		if(frames[i].data == 0) {
-			std::cout << "Cannot read " << (root_dir + frame_name) << std::endl;
-			return 1;
-		}
-		if(frames[i].size() != frames[0].size()) {
-			std::cout << "Size of " << i+1 << "-th frame differs from sizes of previous frames" << std::endl;
-			return 1;
-		}
+	bool is_querying = !region.empty() || !polyline.empty();
+	if( (!selected_ids.empty() || is_querying) && !is_headless ) {
+		std::cout << "Trajectories can be selected only in headless mode" << std::endl;
+		return 1;
 	}
-	in_frames.close();
 
-	// read trajectories
-	std::ifstream in_trajectoires(path_to_trajectories);
-	if( !in_trajectoires.is_open() ) {
-		std::cout << "Cannot open " << path_to_trajectories << std::endl;
+	if(is_querying && window_length > 0) {
+		std::cout << "--region and --crossing need all trajectories, they cannot be used with --window" << std::endl;
 		return 1;
 	}
 
-	int trajectories_video_length;
-	int trajectory_amount;
-	read_dat_header(trajectories_video_length, trajectory_amount, in_trajectoires);
-	if(trajectories_video_length != video_length) {
-		std::cout << "Trajectories are extracted from a video of another length" << std::endl;
+	std::string path_to_partition(arguments[1]);
+	if( path_to_partition.compare(path_to_partition.find_last_of("."), std::string::npos, ".dat") != 0 ) {
+		std::cout << path_to_partition << " must be a .dat file" << std::endl;
 		return 1;
 	}
 
-	std::vector<trajectory_t> trajectories(trajectory_amount);
-	for(trajectory_t & trajectory : trajectories) {
-		read(trajectory, in_trajectoires);
+	// a .bmf list of images or a video file
+	std::string path_to_frames(arguments[2]);
+	size_t extension_position = path_to_frames.find_last_of(".");
+	bool is_video = extension_position == std::string::npos || path_to_frames.compare(extension_position, std::string::npos, ".bmf") != 0;
+
+	std::string root_dir = path_to_frames.substr(0, path_to_frames.find_last_of("/")+1);
+	if(root_dir.compare(path_to_frames) == 0) { // if frames are in current folder
+		root_dir = "./";
 	}
-	in_trajectoires.close();
 
-	// read partition of trajectories
-	std::ifstream in_partition(path_to_partition);
-	if( !in_partition.is_open() ) {
-		std::cout << "Cannot open " << path_to_partition << std::endl;
-		return 1;
+	//// read input
+	// read frames
+	int video_length;
+	std::vector<std::string> frame_paths;
+	video_reader_t video;
+	if(is_video) {
+		if( !video.open(path_to_frames) ) {
+			std::cout << "Cannot read " << path_to_frames << std::endl;
+			return 1;
+		}
+		video_length = video.size();
+	} else {
+		std::ifstream in_frames(path_to_frames);
+		if( !in_frames.is_open() ) {
+			std::cout << "Cannot " << path_to_frames << std::endl;
+			return 1;
+		}
+
+		int dummy;
+		in_frames >> video_length >> dummy;
+
+		frame_paths.resize(video_length);
+		for(std::string & frame_path : frame_paths) {
+			std::string frame_name;
+			in_frames >> frame_name;
+			frame_path = root_dir + frame_name;
+		}
+		in_frames.close();
+	}
+	// a name of a frame for messages
+	auto frame_path = [&](size_t frame_id) {
+		return is_video? path_to_frames + " (frame " + std::to_string(frame_id) + ")": frame_paths[frame_id];
+	};
+
+	std::vector<cv::Mat> frames; // all frames, if they are not cached
+	ppm_sequence_t ppm_sequence; // raw PPM frames are mapped instead of being decoded
+	compressed_sequence_t compressed_sequence;
+	bool is_rgb = false; // mapped frames keep the order of channels of PPM
+	std::unique_ptr<frame_cache_t> frame_cache;
+	cv::Size frame_size;
+	if(is_video) {
+		frame_cache.reset(new frame_cache_t(video_length,
+				[&](size_t i) { return video.read(i); },
+				(size_t)(cache_budget_mb > 0? cache_budget_mb: default_video_cache_mb) << 20));
+		frame_size = video.frame_size();
+	} else if(is_compressed) {
+		std::chrono::steady_clock::time_point compression_start = std::chrono::steady_clock::now();
+		compressed_sequence.open(frame_paths, compression_format);
+		double compression_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - compression_start).count();
+		for(int i=0; i<video_length; ++i) {
+			if(compressed_sequence.frame_size(i).area() == 0) {
+				std::cout << "Cannot read " << frame_path(i) << std::endl;
+				return 1;
+			}
+			if(compressed_sequence.frame_size(i) != compressed_sequence.frame_size(0)) {
+				std::cout << "Size of " << i+1 << "-th frame differs from sizes of previous frames" << std::endl;
+				return 1;
+			}
+		}
+		frame_size = compressed_sequence.frame_size(0);
+		size_t frame_memory = (size_t)frame_size.area() * 3;
+		std::cout << "Compressed " << video_length << " frames in " << compression_time << " s to "
+			<< (compressed_sequence.memory() >> 20) << " MB (" << (double)frame_memory * video_length / std::max<size_t>(compressed_sequence.memory(), 1)
+			<< " times less than decoded)" << std::endl;
+		frame_cache.reset(new frame_cache_t(video_length,
+				[&](size_t i) { return compressed_sequence.decode(i); },
+				compressed_cache_frames * frame_memory));
+	} else if(cache_budget_mb > 0) { // an explicit budget is kept even for frames which could be mapped
+		frame_cache.reset(new frame_cache_t(video_length,
+				[&](size_t i) { return cv::imread(frame_paths[i]); },
+				(size_t)cache_budget_mb << 20));
+		cv::Mat first_frame = frame_cache->get(0);
+		if(first_frame.data == 0) {
+			std::cout << "Cannot read " << frame_path(0) << std::endl;
+			return 1;
+		}
+		frame_size = first_frame.size();
+	} else if( ppm_sequence.open(frame_paths, frames) ) {
+		is_rgb = true;
+	} else {
+		std::chrono::steady_clock::time_point loading_start = std::chrono::steady_clock::now();
+		load_frames(frame_paths, frames);
+		double loading_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - loading_start).count();
+		std::cout << "Decoded " << frames.size() << " frames in " << loading_time << " s ("
+			<< frames.size() / std::max(loading_time, 1e-9) << " frames/s)" << std::endl;
+	}
+	if( !frame_cache ) {
+		for(size_t i=0; i<frames.size(); ++i) {
+			if(frames[i].data == 0) {
+				std::cout << "Cannot read " << frame_path(i) << std::endl;
+				return 1;
+			}
+			if(frames[i].size() != frames[0].size()) {
+				std::cout << "Size of " << i+1 << "-th frame differs from sizes of previous frames" << std::endl;
+				return 1;
+			}
+		}
+		frame_size = frames[0].size();
 	}
 
+	// read trajectories and partition of trajectories
+	// Note: it is supposed trajectory and its partition have the same index
+	int trajectories_video_length;
+	trajectory_store_t trajectories;
 	int partitions_video_length;
-	int partitions_trajectory_amount;
-	read_dat_header(partitions_video_length, partitions_trajectory_amount, in_partition);
+	partition_store_t partitions;
+	dat_follower_t trajectories_follower, partitions_follower;
+	trajectory_window_t window;
+	if(window_length > 0) {
+		if( !window.open(path_to_trajectories, path_to_partition) ) {
+			std::cout << "Cannot index " << path_to_trajectories << " and " << path_to_partition << std::endl;
+			return 1;
+		}
+		trajectories_video_length = partitions_video_length = window.video_length();
+		window_length = std::min(window_length, video_length);
+		if( !window.set_window(0, window_length, trajectories, partitions) ) {
+			std::cout << "Cannot read " << path_to_trajectories << " or " << path_to_partition << std::endl;
+			return 1;
+		}
+	} else if(is_following) {
+		if( !trajectories_follower.open(path_to_trajectories) ) {
+			std::cout << "Cannot open " << path_to_trajectories << std::endl;
+			return 1;
+		}
+		if( !partitions_follower.open(path_to_partition) ) {
+			std::cout << "Cannot open " << path_to_partition << std::endl;
+			return 1;
+		}
+		trajectories_follower.poll(trajectories);
+		partitions_follower.poll(partitions);
+		if( trajectories_follower.is_malformed() ) {
+			std::cout << "Cannot read " << path_to_trajectories << std::endl;
+			return 1;
+		}
+		if( partitions_follower.is_malformed() ) {
+			std::cout << "Cannot read " << path_to_partition << std::endl;
+			return 1;
+		}
+		// headers may be not written yet
+		trajectories_video_length = trajectories_follower.has_header()? trajectories_follower.video_length(): video_length;
+		partitions_video_length = partitions_follower.has_header()? partitions_follower.video_length(): video_length;
+	} else {
+		if( !load_trajectory_file(path_to_trajectories, trajectories_video_length, trajectories) ) {
+			std::cout << "Cannot read " << path_to_trajectories << std::endl;
+			return 1;
+		}
+		if( !load_partitions(path_to_partition, partitions_video_length, partitions) ) {
+			std::cout << "Cannot read " << path_to_partition << std::endl;
+			return 1;
+		}
+		if(partitions.size() != trajectories.size()) {
+			std::cout << "There is no 1-to-1 correspondence btw trajectories and their partitions" << std::endl;
+			return 1;
+		}
+		if( !partitions.fits(trajectories, 0, trajectories.size()) ) {
+			std::cout << "Partitions have cut points outside of their trajectories" << std::endl;
+			return 1;
+		}
+	}
+	if(trajectories_video_length != video_length) {
+		std::cout << "Trajectories are extracted from a video of another length" << std::endl;
+		return 1;
+	}
 	if(partitions_video_length != video_length) {
 		std::cout << "Partitions were extracted from a video of another length" << std::endl;
 		return 1;
 	}
-	if(partitions_trajectory_amount != trajectory_amount) {
-		std::cout << "There is no 1-to-1 correspondence btw trajectories and their partitions" << std::endl;
+	// trajectories with a partition. While following, one file may be ahead of another
+	size_t amount_of_shown_trajectories = std::min(trajectories.size(), partitions.size());
+	if( is_following && !partitions.fits(trajectories, 0, amount_of_shown_trajectories) ) {
+		std::cout << "Partitions have cut points outside of their trajectories" << std::endl;
 		return 1;
 	}
 
-
-	// Note: it is supposed trajectory and its partition have the same index
-	std::vector<partition_t> partitions(trajectory_amount);
-	for(partition_t & partition : partitions) {
-		read(partition, in_partition);
-	}
-	in_partition.close();
-
 	//// prepare for vizualization
-	draw_trajectories(trajectories, partitions, frames);
-
-	// create a map: a trajectory point to the index of the trajectory
-	int video_size[] = {frames[0].size().width, frames[0].size().height, video_length}; // sizes of all frames are the same
-	cv::Mat pos_2_trajectory_id(3/*amount of dims*/, video_size, CV_32SC1, not_trajectory_index);
-	int trajectory_id=0;
-	for(const trajectory_t & trajectory : trajectories) {
-		int frame_id = trajectory._start_frame;
-		for( const trajectory_t::point_t & point : trajectory._points ) {
-
-			// TODO the same piece of code is in draw_trajectories. Make a separate function
-			int floor_x = floor(point.x); 
-			int floor_y = floor(point.y); 
-			int ceil_x = floor_x + 1;
-			int ceil_y = floor_y + 1;
-
-			cv::Point p1, p2; 
-			p1.x = (floor_x-indent<0)? 0: floor_x-indent; 
-			p1.y = (floor_y-indent<0)? 0: floor_y-indent; 
-			p2.x = (ceil_x+indent>=frames[0].size().width-1)? frames[0].size().width-1: ceil_x+indent;
-			p2.y = (ceil_y+indent>=frames[0].size().height-1)? frames[0].size().height-1: ceil_y+indent; 
-
-			for(int y=p1.y; y<=p2.y; ++y)
-			for(int x=p1.x; x<=p2.x; ++x) {
-				pos_2_trajectory_id.at<int>(x, y, frame_id) = trajectory_id;
-			}
-			frame_id++;
-		}
-		trajectory_id++;
-	}
+	// bucket points of trajectories by frames for drawing
+	frame_index_t index;
+	index.build(trajectories, partitions, amount_of_shown_trajectories, video_length);
 
-	// prepare mouse call handler
 	cv::Scalar background_color(0,0,0);
-	int current_frame_number = 0;
-
 	std::vector<cv::Scalar> colors(11);
 	colors[0] = cv::Scalar(255, 0, 0, 1);
 	colors[1] = cv::Scalar(0, 255, 0);
@@ -245,35 +468,300 @@ int main(int argc, char * argv[])
 	colors[9] = cv::Scalar(0, 125, 125);
 	colors[10] = cv::Scalar(125, 125, 125);
 
-	mouse_callback_input_t mouse_callback_input(current_frame_number, pos_2_trajectory_id, trajectories, partitions, colors);
-	mouse_callback_input._plot_xy = cv::Mat(frames[0].size(), CV_8UC3, background_color);
+	trajectory_rasterizer_t rasterizer(indent);
+	// Frames as they are read, BGR or RGB
+	auto get_source_frame = [&](size_t frame_id) {
+		return frame_cache? frame_cache->get(frame_id): frames[frame_id];
+	};
+	// Stops the viewer if a frame cannot be read
+	auto check_frame = [&](size_t frame_id, const cv::Mat & frame) {
+		if(frame.data == 0) {
+			std::cout << "Cannot read " << frame_path(frame_id) << std::endl;
+			exit(1);
+		}
+		if(frame.size() != frame_size) {
+			std::cout << "Size of " << frame_id+1 << "-th frame differs from size of the first frame" << std::endl;
+			exit(1);
+		}
+	};
+
+	// Export of frames with trajectories. Frames are drawn here by batches, which are encoded and written in background,
+	// so the viewer stays responsive. In window mode the export has its own window
+	frame_exporter_t exporter;
+	int next_exported_frame = 0;
+	size_t amount_of_reported_frames = 0;
+	std::chrono::steady_clock::time_point export_start;
+	trajectory_window_t export_window;
+	trajectory_store_t export_trajectories;
+	partition_store_t export_partitions;
+	frame_index_t export_index;
+	std::vector<cv::Mat> exported_batch;
+	auto start_export = [&]() {
+		if( !exporter.start(root_dir + "Trajectories", export_format, video_length, frame_size) ) {
+			std::cout << "Cannot export frames to " << root_dir << std::endl;
+			return false;
+		}
+		if(window_length > 0 && !export_window.open(path_to_trajectories, path_to_partition)) {
+			std::cout << "Cannot index " << path_to_trajectories << " and " << path_to_partition << std::endl;
+			exit(1);
+		}
+		next_exported_frame = 0;
+		amount_of_reported_frames = 0;
+		export_start = std::chrono::steady_clock::now();
+		return true;
+	};
+	// Pushes the next batch of frames. Unless is_blocking, the batch is not larger than free space of the queue
+	auto feed_exporter = [&](bool is_blocking) {
+		size_t batch_size = is_blocking? export_batch_size: std::min<size_t>(exporter.free_space(), export_batch_size);
+		int amount = std::min<int>(batch_size, video_length - next_exported_frame);
+		if(amount <= 0) {
+			return;
+		}
+		int first = next_exported_frame;
+		int last = first + amount;
+		const frame_index_t * exported_index = &index;
+		if(window_length > 0) {
+			if( !export_window.contains(first) ) {
+				if( !export_window.set_window(first, std::min(first + window_length, video_length), export_trajectories, export_partitions) ) {
+					std::cout << "Cannot read " << path_to_trajectories << " or " << path_to_partition << std::endl;
+					exit(1);
+				}
+				export_index.build(export_trajectories, export_partitions, export_trajectories.size(), video_length);
+			}
+			last = std::min<int>(last, export_window.last_frame());
+			exported_index = &export_index;
+		}
+		rasterizer.draw(*exported_index, first, last, get_source_frame, is_rgb, exported_batch);
+		for(int id=first; id<last; ++id) {
+			check_frame(id, exported_batch[id-first]);
+			exporter.push(id, exported_batch[id-first]);
+		}
+		next_exported_frame = last;
+	};
+	auto report_export = [&]() {
+		size_t amount_of_written = exporter.amount_of_written();
+		if(amount_of_written == amount_of_reported_frames) {
+			return;
+		}
+		amount_of_reported_frames = amount_of_written;
+		std::cout << "\rExported " << amount_of_written << "/" << exporter.amount() << " frames" << std::flush;
+		if(amount_of_written == exporter.amount()) {
+			double export_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - export_start).count();
+			std::cout << " in " << export_time << " s (" << amount_of_written / std::max(export_time, 1e-9) << " frames/s)";
+			if(exporter.amount_of_failed() > 0) {
+				std::cout << ", " << exporter.amount_of_failed() << " frames cannot be written";
+			}
+			std::cout << std::endl;
+			if( !exporter.first_error().empty() ) {
+				std::cout << "Export failed at " << exporter.first_error() << std::endl;
+			}
+			exporter.close();
+		}
+	};
+
+	if(is_headless) {
+		if(is_querying) {
+			std::chrono::steady_clock::time_point indexing_start = std::chrono::steady_clock::now();
+			segment_rtree_t rtree;
+			rtree.build(trajectories, amount_of_shown_trajectories);
+			double indexing_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - indexing_start).count();
+			std::cout << "Indexed " << rtree.amount_of_pieces() << " pieces of trajectories in " << indexing_time << " s" << std::endl;
+
+			double first_frame = query_frames.empty()? 0: query_frames[0];
+			double last_frame = query_frames.empty()? video_length-1: query_frames[1];
+			std::vector<size_t> found_ids;
+			if( !region.empty() ) {
+				box3_t box = {{std::min(region[0], region[2]), std::min(region[1], region[3]), first_frame},
+					{std::max(region[0], region[2]), std::max(region[1], region[3]), last_frame}};
+				rtree.query(box, found_ids);
+				std::cout << found_ids.size() << " trajectories pass through the region:";
+				for(size_t id : found_ids) {
+					std::cout << " " << id;
+					if(std::find(selected_ids.begin(), selected_ids.end(), id) == selected_ids.end()) {
+						selected_ids.push_back(id);
+					}
+				}
+				std::cout << std::endl;
+			}
+			if( !polyline.empty() ) {
+				std::vector<cv::Point2d> vertices;
+				for(size_t i=0; i<polyline.size(); i+=2) {
+					vertices.push_back(cv::Point2d(polyline[i], polyline[i+1]));
+				}
+				rtree.crossing(vertices, first_frame, last_frame, found_ids);
+				std::cout << found_ids.size() << " trajectories cross the polyline:";
+				for(size_t id : found_ids) {
+					std::cout << " " << id;
+					if(std::find(selected_ids.begin(), selected_ids.end(), id) == selected_ids.end()) {
+						selected_ids.push_back(id);
+					}
+				}
+				std::cout << std::endl;
+			}
+		}
+
+		// xy projections of selected trajectories. In window mode ids are indices in the files
+		cv::Mat plot_xy(frame_size, CV_8UC3, background_color);
+		trajectory_store_t selected_trajectories;
+		partition_store_t selected_partitions;
+		for(size_t k=0; k<selected_ids.size(); ++k) {
+			size_t id = selected_ids[k];
+			if(window_length > 0) {
+				if(id >= window.size() || !window.read(id, selected_trajectories, selected_partitions)) {
+					std::cout << "Cannot read trajectory " << id << std::endl;
+					return 1;
+				}
+				size_t i = selected_trajectories.size() - 1;
+				draw_xy_projection(selected_trajectories.x(i), selected_trajectories.y(i), selected_partitions[i], colors[k % colors.size()], plot_xy);
+			} else {
+				if(id >= amount_of_shown_trajectories) {
+					std::cout << "There is no trajectory " << id << std::endl;
+					return 1;
+				}
+				draw_xy_projection(trajectories.x(id), trajectories.y(id), partitions[id], colors[k % colors.size()], plot_xy);
+			}
+		}
+		if( !selected_ids.empty() && !cv::imwrite(root_dir + "plot_xy.jpg", plot_xy) ) {
+			std::cout << "Cannot write " << root_dir << "plot_xy.jpg" << std::endl;
+			return 1;
+		}
+
+		// all frames with trajectories
+		if( !start_export() ) {
+			return 1;
+		}
+		while(amount_of_reported_frames < exporter.amount()) {
+			feed_exporter(true);
+			report_export();
+			if(next_exported_frame == video_length) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		return exporter.amount_of_failed() > 0? 1: 0;
+	}
+
+	// find trajectories by points of frames: drawn squares, or the nearest points if a radius is given
+	frame_grid_t grid(index, indent);
+	trajectory_picker_t picker(index);
+	if(pick_radius == 0) {
+		grid.build(frame_size);
+	}
+
+	// prepare mouse call handler
+	int current_frame_number = 0;
+
+	mouse_callback_input_t mouse_callback_input(current_frame_number, grid, picker, pick_radius, trajectories, partitions, colors);
+	mouse_callback_input._plot_xy = cv::Mat(frame_size, CV_8UC3, background_color);
 	mouse_callback_input._plot_xy_name = std::string("xy projection"); 
 
 	//// do vizualization
 	std::string current_frame_name("Current frame");
-	cv::imshow(current_frame_name, frames[current_frame_number]);
+	mouse_callback_input._frame_name = current_frame_name;
+	// Frames are kept untouched, trajectories are drawn on a copy of a frame when it is shown for the first time
+	auto render_frame = [&](size_t frame_id) {
+		cv::Mat frame = get_source_frame(frame_id);
+		check_frame(frame_id, frame);
+		cv::Mat drawn_frame;
+		if(is_rgb) {
+			cv::cvtColor(frame, drawn_frame, CV_RGB2BGR);
+		} else {
+			frame.copyTo(drawn_frame);
+		}
+		rasterizer.draw(index, frame_id, drawn_frame);
+		return drawn_frame;
+	};
+	// Drawn frames are dropped when shown trajectories change
+	frame_cache_t drawn_frames(video_length, render_frame, (size_t)overlay_cache_mb << 20);
+
+	// Returns the frame with trajectories drawn. In window mode the window is moved to the frame if needed
+	auto get_frame = [&](int frame_id) {
+		if( window_length > 0 && !window.contains(frame_id) ) {
+			int first_frame = std::max(0, std::min(frame_id - window_length/2, video_length - window_length));
+			if( !window.set_window(first_frame, first_frame + window_length, trajectories, partitions) ) {
+				std::cout << "Cannot read " << path_to_trajectories << " or " << path_to_partition << std::endl;
+				exit(1);
+			}
+			amount_of_shown_trajectories = trajectories.size();
+			index.build(trajectories, partitions, amount_of_shown_trajectories, video_length);
+			if(pick_radius == 0) {
+				grid.build(frame_size);
+			}
+			picker.clear();
+			drawn_frames.clear();
+		}
+		return drawn_frames.get(frame_id);
+	};
+	// Shows the current frame, the mouse handler draws a selection over it
+	auto show_frame = [&]() {
+		mouse_callback_input._shown_frame = get_frame(current_frame_number);
+		cv::imshow(current_frame_name, mouse_callback_input._shown_frame);
+	};
+
+	show_frame();
 	cv::setMouseCallback(current_frame_name, show_graphs, &mouse_callback_input);
 	cv::imshow(mouse_callback_input._plot_xy_name, mouse_callback_input._plot_xy);
-	cv::moveWindow(mouse_callback_input._plot_xy_name, frames[0].size().width, 0);
+	cv::moveWindow(mouse_callback_input._plot_xy_name, frame_size.width, 0);
 
+	std::chrono::steady_clock::time_point last_poll = std::chrono::steady_clock::now();
 	for(;;) {
-		int c = cv::waitKey(0);
+		bool is_exporting = exporter.is_running();
+		int c = cv::waitKey(is_exporting? 1: (is_following? follow_interval_ms: 0));
 		if( (c & 255) == 27 ) { // if ESC
 			return 0;
 		}
+		if(is_exporting) {
+			feed_exporter(false);
+			report_export();
+		}
+		if(c == -1) { // no key is pressed while following or exporting
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if( !is_following || now - last_poll < std::chrono::milliseconds(follow_interval_ms) ) {
+				continue;
+			}
+			last_poll = now;
+			trajectories_follower.poll(trajectories);
+			partitions_follower.poll(partitions);
+			if( trajectories_follower.is_malformed() || partitions_follower.is_malformed() ) {
+				// records before the malformed one are still shown
+				std::cout << "Malformed record in " << (trajectories_follower.is_malformed()? path_to_trajectories: path_to_partition) << ", it is not followed anymore" << std::endl;
+				is_following = false;
+			}
+			size_t amount_of_trajectories = std::min(trajectories.size(), partitions.size());
+			if( !partitions.fits(trajectories, amount_of_shown_trajectories, amount_of_trajectories) ) {
+				std::cout << "Partitions have cut points outside of their trajectories" << std::endl;
+				return 1;
+			}
+			if(amount_of_trajectories > amount_of_shown_trajectories) {
+				// only new trajectories are indexed, trees of the picker are rebuilt for frames they touch
+				index.append(trajectories, partitions, amount_of_shown_trajectories, amount_of_trajectories, video_length);
+				amount_of_shown_trajectories = amount_of_trajectories;
+				if(pick_radius == 0) {
+					grid.append();
+				}
+				drawn_frames.clear();
+				show_frame();
+			}
+			continue;
+		}
 		switch( (char)c) {
 			case 'f':
 				// Go to the next frame
 				if(current_frame_number < video_length-1) {
 					++current_frame_number;
-					cv::imshow(current_frame_name, frames[current_frame_number]);
+					show_frame();
+					if(frame_cache) {
+						frame_cache->prefetch(current_frame_number, 1);
+					}
 				}
 				break;
 			case 'b':
 				// Go to the previous frame
 				if(current_frame_number > 0) {
 					--current_frame_number;
-					cv::imshow(current_frame_name, frames[current_frame_number]);
+					show_frame();
+					if(frame_cache) {
+						frame_cache->prefetch(current_frame_number, -1);
+					}
 				}
 				break;
 			case 'r':
@@ -294,11 +782,10 @@ int main(int argc, char * argv[])
 						cv::imwrite(root_dir + "plot_xy.jpg", mouse_callback_input._plot_xy);
 						break;
 					case 't': // print trajectories
-						int id=0;
-						for(const cv::Mat & frame : frames) {
-							std::string str_id = std::to_string(id++);
-							str_id = std::string(4 - str_id.length(), '0') + str_id;
-							cv::imwrite(root_dir + "Trajectories" + str_id + ".jpg", frame);
+						if( exporter.is_running() ) {
+							std::cout << "Frames are being exported" << std::endl;
+						} else {
+							start_export();
 						}
 						break;
 				}
@@ -308,168 +795,207 @@ int main(int argc, char * argv[])
 	return 0;
 }
 
-static void show_graphs( int event, int x, int y, int, void * args)
+static void show_graphs( int event, int x, int y, int flags, void * args)
 {
-	if(event == cv::EVENT_MOUSEMOVE) {
-		return;
-	}
+	mouse_callback_input_t * callback_input = (mouse_callback_input_t*)args;
+	unsigned int current_frame = callback_input->_current_frame_number;
 
 	switch(event) {
 		case cv::EVENT_LBUTTONDOWN: {
-			mouse_callback_input_t * callback_input = (mouse_callback_input_t*)args;
-
-			unsigned int current_frame = callback_input->_current_frame_number;
-
-			int seleceted_traj_id = callback_input->_pos_2_trajectory_id.at<int>(x, y, current_frame);
-			if(seleceted_traj_id == not_trajectory_index) { // trajectory is not selected
-				return;
-			}
-			if( callback_input->_num_drawn_trajectories >= callback_input->_color_scheme.size() ) {
-				std::cout << "Not enough colors. Press 'r' to refresh" << std::endl;
+			callback_input->_is_dragging = true;
+			callback_input->_lasso.assign(1, cv::Point(x, y));
+			break;
+		}
+		case cv::EVENT_MOUSEMOVE: {
+			if( !callback_input->_is_dragging || !(flags & cv::EVENT_FLAG_LBUTTON) ) {
 				break;
 			}
-			
-			const trajectory_t & trajectory = callback_input->_trajectories[seleceted_traj_id];
-			const partition_t & partition = callback_input->_partitions[seleceted_traj_id];
-
-			// Select a color
-			cv::Scalar color_for_projections = callback_input->_color_scheme[callback_input->_num_drawn_trajectories];
-			cv::Scalar color_for_partition = cv::Scalar(0,0,255);
-
-			std::vector<trajectory_t::component_t> x, y;
-			trajectory.get_x_components(x);
-			trajectory.get_y_components(y);
-
-			// round trajectories for drawing
-			std::vector<int> rounded_x(trajectory.size()), rounded_y(trajectory.size());
-			for(size_t i=0; i<trajectory.size(); ++i) {
-				rounded_x[i] = lround(x[i]);
-				rounded_y[i] = lround(y[i]);
+			callback_input->_lasso.push_back(cv::Point(x, y));
+
+			// a rectangle, or a lasso with Shift
+			cv::Mat preview = callback_input->_shown_frame.clone();
+			if(flags & cv::EVENT_FLAG_SHIFTKEY) {
+				cv::polylines(preview, std::vector<std::vector<cv::Point> >(1, callback_input->_lasso), true, selection_color);
+			} else {
+				cv::rectangle(preview, callback_input->_lasso.front(), cv::Point(x, y), selection_color);
 			}
-
-			// get trajectory partition points
-			std::vector<int> x_partition(partition.size());
-			std::vector<int> y_partition(partition.size());
-			int i=0;
-			for(const partition_t::value_type & p : partition) {
-				x_partition[i] = rounded_x[p];
-				y_partition[i] = rounded_y[p];
-				i++;
+			cv::imshow(callback_input->_frame_name, preview);
+			break;
+		}
+		case cv::EVENT_LBUTTONUP: {
+			if( !callback_input->_is_dragging ) {
+				break;
+			}
+			callback_input->_is_dragging = false;
+			cv::Point start = callback_input->_lasso.front();
+
+			std::vector<unsigned int> selected_ids;
+			if( std::abs(x - start.x) <= click_tolerance && std::abs(y - start.y) <= click_tolerance ) {
+				// a click. With Ctrl, several nearest trajectories are picked
+				if(callback_input->_pick_radius == 0) {
+					int selected_id = callback_input->_grid.find(current_frame, start.x, start.y);
+					if(selected_id != frame_grid_t::not_found) {
+						selected_ids.push_back(selected_id);
+					}
+				} else {
+					size_t amount = (flags & cv::EVENT_FLAG_CTRLKEY)? amount_of_nearest: 1;
+					callback_input->_picker.find(current_frame, start.x, start.y, callback_input->_pick_radius, amount, selected_ids);
+				}
+			} else {
+				// trajectories with points inside the rectangle or the lasso at the current frame
+				std::vector<cv::Point> polygon;
+				if(flags & cv::EVENT_FLAG_SHIFTKEY) {
+					polygon.swap(callback_input->_lasso);
+					polygon.push_back(cv::Point(x, y));
+				} else {
+					polygon.push_back(start);
+					polygon.push_back(cv::Point(x, start.y));
+					polygon.push_back(cv::Point(x, y));
+					polygon.push_back(cv::Point(start.x, y));
+				}
+				callback_input->_picker.find(current_frame, polygon, selected_ids);
+				cv::imshow(callback_input->_frame_name, callback_input->_shown_frame);
 			}
+			plot_trajectories(callback_input, selected_ids);
+			break;
+		}
+		case cv::EVENT_RBUTTONDOWN: {
+		// TODO show 3D trajectory
+			break;
+		}
+	}
+}
 
-			// Draw projections and partitions of trajectory
-			// xy
-			draw_curve(rounded_x.cbegin(), rounded_x.cend(), rounded_y.cbegin(), rounded_y.cend(), color_for_projections, callback_input->_plot_xy);
-			draw_points(x_partition.cbegin(), x_partition.cend(), y_partition.cbegin(), y_partition.cend(), color_for_partition, callback_input->_plot_xy);
+// A curve plotted by gnuplot: values at points of a trajectory
+struct curve_t
+{
+	curve_t(const std::string & title, const char * style): _title(title), _style(style) { }
 
-			// Show them
-			cv::imshow(callback_input->_plot_xy_name, callback_input->_plot_xy);
+	std::string _title;
+	const char * _style; // "lines" or "points"
+	std::vector<double> _t; // indices of points
+	std::vector<double> _values;
+}; // curve_t
 
-			// plot speed and accelearation
-			const int template_size=3;
-			if(trajectory.size() < template_size) {
-				break; // trajectory is too short
-			}
+// Plots curves by one command with inline data, so a plot is redrawn once for any amount of curves.
+// No temporary files are made, gnuplot_i allows only 64 of them per plot
+static void plot_curves(gnuplot_ctrl * plot, const std::vector<curve_t> & curves)
+{
+	gnuplot_resetplot(plot);
+	std::string command;
+	for(const curve_t & curve : curves) {
+		if( !curve._values.empty() ) {
+			command += (command.empty()? "plot": ",") + std::string(" '-' title \"") + curve._title + "\" with " + curve._style;
+		}
+	}
+	if( command.empty() ) {
+		return;
+	}
+	fprintf(plot->gnucmd, "%s\n", command.c_str());
+	for(const curve_t & curve : curves) {
+		if( curve._values.empty() ) {
+			continue;
+		}
+		for(size_t i=0; i<curve._values.size(); ++i) {
+			fprintf(plot->gnucmd, "%.18e %.18e\n", curve._t[i], curve._values[i]);
+		}
+		fprintf(plot->gnucmd, "e\n");
+	}
+	fflush(plot->gnucmd);
+}
 
-			// compute speed and acceleration
-			std::vector<trajectory_t::component_t> gaussian, derivative;
-			gaussian_template(template_size, 3.0/*sigma*/, gaussian);
-			derivative_template(template_size, derivative);
-
-			std::vector<trajectory_t::component_t> smooth_x, smooth_y;
-			convolve(x, gaussian, smooth_x);
-			convolve(y, gaussian, smooth_y);
-			smooth_x[0] = smooth_x[1];
-			smooth_x[smooth_x.size()-1] = smooth_x[smooth_x.size()-2];
-			smooth_y[0] = smooth_y[1];
-			smooth_y[smooth_y.size()-1] = smooth_y[smooth_y.size()-2];
-
-			std::vector<trajectory_t::component_t> x_speed, y_speed;
-			convolve(smooth_x, derivative, x_speed);
-			convolve(smooth_y, derivative, y_speed);
-			x_speed[0] = x_speed[1];
-			x_speed[x_speed.size()-1] = x_speed[x_speed.size()-2];
-			y_speed[0] = y_speed[1];
-			y_speed[y_speed.size()-1] = y_speed[y_speed.size()-2];
-
-			std::vector<trajectory_t::component_t> x_acceleration, y_acceleration;
-			convolve(x_speed, derivative, x_acceleration);
-			convolve(y_speed, derivative, y_acceleration);
-			x_acceleration[0] = x_acceleration[1];
-			x_acceleration[x_acceleration.size()-1] = x_acceleration[x_acceleration.size()-2];
-			y_acceleration[0] = y_acceleration[1];
-			y_acceleration[y_acceleration.size()-1] = y_acceleration[y_acceleration.size()-2];
-
-			// Prepare to plot
-			for(int i=0; i<2; ++i) {
-				gnuplot_resetplot(callback_input->_plot_xt[i]);
-				gnuplot_resetplot(callback_input->_plot_yt[i]);
-				gnuplot_setstyle(callback_input->_plot_xt[i], (char*)"lines");
-				gnuplot_setstyle(callback_input->_plot_yt[i], (char*)"lines");
-			}
-			char trajectory_title[50];
-			sprintf(trajectory_title, "trajectory %d", callback_input->_num_drawn_trajectories);
-			char speed_title[50];
-			sprintf(speed_title, "speed %d", callback_input->_num_drawn_trajectories);
-			char acceleration_title[50];
-			sprintf(acceleration_title, "acceleration %d", callback_input->_num_drawn_trajectories);
-
-			// Plot projections, speed and acceleration
-			// xt
-			gnuplot_plot_x(callback_input->_plot_xt[0], &x[0], trajectory.size(), trajectory_title);
-			gnuplot_plot_x(callback_input->_plot_xt[0], &smooth_x[0], smooth_x.size(), (char*)"smooth");
-
-			gnuplot_plot_x(callback_input->_plot_xt[1], &x_speed[0], x_speed.size(), speed_title);
-			gnuplot_plot_x(callback_input->_plot_xt[1], &x_acceleration[0], x_acceleration.size(), acceleration_title);
-			// yt
-			gnuplot_plot_x(callback_input->_plot_yt[0], &y[0], trajectory.size(), trajectory_title);
-			gnuplot_plot_x(callback_input->_plot_yt[0], &smooth_y[0], smooth_y.size(), (char*)"smooth");
-
-			gnuplot_plot_x(callback_input->_plot_yt[1], &y_speed[0], y_speed.size(), speed_title);
-			gnuplot_plot_x(callback_input->_plot_yt[1], &y_acceleration[0], y_acceleration.size(), acceleration_title);
-
-			// get partitions
-			std::vector<trajectory_t::component_t> x_speed_partition(partition.size());
-			std::vector<trajectory_t::component_t> y_speed_partition(partition.size());
-			i=0;
-			for(const partition_t::value_type & p : partition) {
-				x_speed_partition[i] = x_speed[p];
-				y_speed_partition[i] = y_speed[p];
-				i++;
-			}
-			std::vector<trajectory_t::component_t> x_acceleration_partition(partition.size());
-			std::vector<trajectory_t::component_t> y_acceleration_partition(partition.size());
-			i=0;
-			for(const partition_t::value_type & p : partition) {
-				x_acceleration_partition[i] = x_acceleration[p];
-				y_acceleration_partition[i] = y_acceleration[p];
-				i++;
-			}
-			// gnu plot requires the same type for both variables
-			std::vector<trajectory_t::component_t> t_partition(partition.begin(), partition.end());
+// Adds curves of a projection of the trajectory: to curves[0] the projection and its smoothed version,
+// to curves[1] speed and acceleration with their values at cut points
+static void add_projection_curves(const double * data, size_t size, partition_store_t::cut_points_t partition, unsigned int number,
+		std::vector<curve_t> curves[2])
+{
+	// compute speed and acceleration
+	const int template_size=3;
+	std::vector<double> gaussian, derivative;
+	gaussian_template(template_size, 3.0/*sigma*/, gaussian);
+	derivative_template(template_size, derivative);
+
+	std::vector<double> smooth;
+	convolve(data, size, gaussian, smooth);
+	smooth[0] = smooth[1];
+	smooth[smooth.size()-1] = smooth[smooth.size()-2];
+
+	std::vector<double> speed;
+	convolve(smooth, derivative, speed);
+	speed[0] = speed[1];
+	speed[speed.size()-1] = speed[speed.size()-2];
+
+	std::vector<double> acceleration;
+	convolve(speed, derivative, acceleration);
+	acceleration[0] = acceleration[1];
+	acceleration[acceleration.size()-1] = acceleration[acceleration.size()-2];
+
+	std::string suffix = " " + std::to_string(number);
+	curve_t trajectory_curve("trajectory" + suffix, "lines");
+	trajectory_curve._values.assign(data, data + size);
+	curve_t smooth_curve("smooth" + suffix, "lines");
+	smooth_curve._values.swap(smooth);
+	curve_t speed_curve("speed" + suffix, "lines");
+	speed_curve._values = speed;
+	curve_t acceleration_curve("acceleration" + suffix, "lines");
+	acceleration_curve._values = acceleration;
+	for(curve_t * curve : {&trajectory_curve, &smooth_curve, &speed_curve, &acceleration_curve}) {
+		for(size_t i=0; i<curve->_values.size(); ++i) {
+			curve->_t.push_back(i);
+		}
+	}
 
-			// perepare to plot
-			for(int i=0; i<2; ++i) {
-				gnuplot_setstyle(callback_input->_plot_yt[i], (char*)"points");
-				gnuplot_setstyle(callback_input->_plot_xt[i], (char*)"points");
-			}
+	// get partitions
+	curve_t speed_partition("partition" + suffix, "points");
+	curve_t acceleration_partition("partition" + suffix, "points");
+	for(const partition_store_t::cut_point_t & p : partition) {
+		speed_partition._t.push_back(p);
+		speed_partition._values.push_back(speed[p]);
+		acceleration_partition._t.push_back(p);
+		acceleration_partition._values.push_back(acceleration[p]);
+	}
 
-			// plot pratition points
-			// xt
-			gnuplot_plot_xy(callback_input->_plot_xt[1], &t_partition[0], &x_speed_partition[0], x_speed_partition.size(), (char*)"partition");
-			gnuplot_plot_xy(callback_input->_plot_xt[1], &t_partition[0], &x_acceleration_partition[0], x_acceleration_partition.size(), (char*)"partition");
-			// ty
-			gnuplot_plot_xy(callback_input->_plot_yt[1], &t_partition[0], &y_speed_partition[0], y_speed_partition.size(), (char*)"partition");
-			gnuplot_plot_xy(callback_input->_plot_yt[1], &t_partition[0], &y_acceleration_partition[0], y_acceleration_partition.size(), (char*)"partition");
+	curves[0].push_back(trajectory_curve);
+	curves[0].push_back(smooth_curve);
+	curves[1].push_back(speed_curve);
+	curves[1].push_back(acceleration_curve);
+	curves[1].push_back(speed_partition);
+	curves[1].push_back(acceleration_partition);
+}
 
+static void plot_trajectories(mouse_callback_input_t * callback_input, const std::vector<unsigned int> & trajectory_ids)
+{
+	if( trajectory_ids.empty() ) {
+		return;
+	}
 
-			callback_input->_num_drawn_trajectories++;
-			break;
-		}
-		case cv::EVENT_RBUTTONDOWN: {
-		// TODO show 3D trajectory
-			break;
+	std::vector<curve_t> xt_curves[2], yt_curves[2];
+	for(unsigned int trajectory_id : trajectory_ids) {
+		trajectory_store_t::components_t x = callback_input->_trajectories.x(trajectory_id);
+		trajectory_store_t::components_t y = callback_input->_trajectories.y(trajectory_id);
+		partition_store_t::cut_points_t partition = callback_input->_partitions[trajectory_id];
+
+		// Draw projections and partitions of trajectory. Colors are reused when all are taken
+		// xy
+		unsigned int number = callback_input->_num_drawn_trajectories++;
+		cv::Scalar color_for_projections = callback_input->_color_scheme[number % callback_input->_color_scheme.size()];
+		draw_xy_projection(x, y, partition, color_for_projections, callback_input->_plot_xy);
+
+		// speed and accelearation
+		const size_t template_size=3;
+		if(x.size() < template_size) {
+			continue; // trajectory is too short
 		}
+		std::vector<double> x_buffer, y_buffer;
+		add_projection_curves(as_doubles(x, x_buffer), x.size(), partition, number, xt_curves);
+		add_projection_curves(as_doubles(y, y_buffer), y.size(), partition, number, yt_curves);
+	}
+
+	// Show them
+	cv::imshow(callback_input->_plot_xy_name, callback_input->_plot_xy);
+	for(int i=0; i<2; ++i) {
+		plot_curves(callback_input->_plot_xt[i], xt_curves[i]);
+		plot_curves(callback_input->_plot_yt[i], yt_curves[i]);
 	}
 }
 
@@ -477,6 +1003,9 @@ void draw_curve( std::vector<int>::const_iterator x_begin, std::vector<int>::con
 		std::vector<int>::const_iterator y_begin, std::vector<int>::const_iterator y_end, const cv::Scalar & color, cv::Mat & out)
 {
 	assert( std::distance(x_begin, x_end) == std::distance(y_begin, y_end) );
+	if(x_begin == x_end) {
+		return;
+	}
 	for(auto x = x_begin+1, y = y_begin+1; x!=x_end && y!=y_end; ++x, ++y) {
 		cv::Point from = cv::Point(*(x-1), *(y-1));
 		cv::Point to = cv::Point(*x, *y);
@@ -492,17 +1021,44 @@ void draw_points( std::vector<int>::const_iterator x_begin, std::vector<int>::co
 	}
 }
 
-void draw_trajectories(const std::vector<trajectory_t> & trajectories, const std::vector<cv::Scalar> & color_scheme, std::vector<cv::Mat> & video)
+void draw_xy_projection(trajectory_store_t::components_t x, trajectory_store_t::components_t y, partition_store_t::cut_points_t partition,
+		const cv::Scalar & color, cv::Mat & out)
+{
+	cv::Scalar color_for_partition = cv::Scalar(0,0,255);
+
+	// round trajectories for drawing
+	std::vector<int> rounded_x(x.size()), rounded_y(y.size());
+	for(size_t i=0; i<x.size(); ++i) {
+		rounded_x[i] = lround(x[i]);
+		rounded_y[i] = lround(y[i]);
+	}
+
+	// get trajectory partition points
+	std::vector<int> x_partition(partition.size());
+	std::vector<int> y_partition(partition.size());
+	int i=0;
+	for(const partition_store_t::cut_point_t & p : partition) {
+		x_partition[i] = rounded_x[p];
+		y_partition[i] = rounded_y[p];
+		i++;
+	}
+
+	draw_curve(rounded_x.cbegin(), rounded_x.cend(), rounded_y.cbegin(), rounded_y.cend(), color, out);
+	draw_points(x_partition.cbegin(), x_partition.cend(), y_partition.cbegin(), y_partition.cend(), color_for_partition, out);
+}
+
+void draw_trajectories(const trajectory_store_t & trajectories, const std::vector<cv::Scalar> & color_scheme, std::vector<cv::Mat> & video)
 {
 	int width = video[0].size().width; 
 	int height = video[0].size().height;
 
-	for(const trajectory_t & trajectory : trajectories ) {
-		int frame_id = trajectory._start_frame;
-		int i=0;
-		for(const trajectory_t::point_t & point : trajectory._points ) {
-			int floor_x = floor(point.x); 
-			int floor_y = floor(point.y); 
+	for(size_t k=0; k<trajectories.size(); ++k ) {
+		trajectory_store_t::components_t x = trajectories.x(k);
+		trajectory_store_t::components_t y = trajectories.y(k);
+		int frame_id = trajectories.start_frame(k);
+		for(size_t i=0; i<x.size(); ++i ) {
+			int floor_x = floor(x[i]); 
+			int floor_y = floor(y[i]); 
 			int ceil_x = floor_x + 1;
 			int ceil_y = floor_y + 1;
 
@@ -514,55 +1070,21 @@ void draw_trajectories(const std::vector<trajectory_t> & trajectories, const std
 
 			cv::rectangle(video[frame_id], p1, p2, color_scheme[i*10], CV_FILLED); 
 			frame_id++;
-			i++;
 		}
 	}
 }
-void draw_trajectories(const std::vector<trajectory_t> & trajectories, const std::vector<partition_t> & partitions, std::vector<cv::Mat> & video)
-{
-	assert(trajectories.size() == partitions.size());
-
-	int width = video[0].size().width;
-	int height = video[0].size().height;
-	// Convert video to HSV
-	for(cv::Mat & frame : video) {
-		cv::cvtColor(frame, frame, CV_BGR2HSV);
-	}
-
-	const int hue_step_deg = 30;
-	const int saturation = 255;
-	const int value = 255;
-
-	for( size_t i=0; i<trajectories.size(); ++i ) {
-
-		const trajectory_t & trajectory = trajectories[i];
-		partition_t::const_iterator p_cut_point = partitions[i].begin();
-		int frame_id = trajectory._start_frame;
-		int hue = 0;
-		cv::Scalar color(hue, 0/*saturation*/, 0/*value*/); // distinguish newly initilalized trajectory by a  unqiue color
-		for( size_t j=0; j<trajectory.size(); ++j ) {
-			
-			int floor_x = floor(trajectory[j].x); 
-			int floor_y = floor(trajectory[j].y); 
-			int ceil_x = floor_x + 1;
-			int ceil_y = floor_y + 1;
-			
-			cv::Point p1, p2; 
-			p1.x = (floor_x-indent<0)? 0: floor_x-indent; 
-			p1.y = (floor_y-indent<0)? 0: floor_y-indent; 
-			p2.x = (ceil_x+indent>=width-1)? width-1: ceil_x+indent;
-			p2.y = (ceil_y+indent>=height-1)? height-1: ceil_y+indent; 
 
-			cv::rectangle(video[frame_id++], p1, p2, color, CV_FILLED); 
-			if( j == *p_cut_point ) {
-				hue= (hue+hue_step_deg)%360;
-				color = cv::Scalar(hue, saturation, value);
-				p_cut_point++;
-			}
+bool parse_numbers(const std::string & text, std::vector<double> & numbers)
+{
+	numbers.clear();
+	std::stringstream in(text);
+	std::string number;
+	while( std::getline(in, number, ',') ) {
+		char * end;
+		numbers.push_back(strtod(number.c_str(), &end));
+		if(number.empty() || *end != 0) {
+			return false;
 		}
 	}
-	// Convert video back to BGR
-	for(cv::Mat & frame : video) {
-		cv::cvtColor(frame, frame, CV_HSV2BGR);
-	}
+	return true;
 }
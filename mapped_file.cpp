@@ -0,0 +1,72 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h> // open
+#include <unistd.h> // close
+#include <sys/mman.h> // mmap munmap madvise
+#include <sys/stat.h> // fstat
+
+mapped_file_t::~mapped_file_t()
+{
+	close();
+}
+
+bool mapped_file_t::open(const std::string & path)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0) {
+		::close(fd);
+		return false;
+	}
+
+	_size = st.st_size;
+	if(_size > 0) { // mmap refuses empty mappings
+		void * data = mmap(0, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(data == MAP_FAILED) {
+			::close(fd);
+			_size = 0;
+			return false;
+		}
+		madvise(data, _size, MADV_SEQUENTIAL);
+		_data = (const char*)data;
+	}
+	::close(fd); // the mapping stays valid after the descriptor is closed
+	_is_open = true;
+	return true;
+}
+
+void mapped_file_t::close()
+{
+	if(_data != 0) {
+		munmap((void*)_data, _size);
+	}
+	_data = 0;
+	_size = 0;
+	_is_open = false;
+}
+
+bool mapped_file_t::is_open() const
+{
+	return _is_open;
+}
+
+const char * mapped_file_t::data() const
+{
+	return _data;
+}
+
+const char * mapped_file_t::end() const
+{
+	return _data + _size;
+}
+
+size_t mapped_file_t::size() const
+{
+	return _size;
+}
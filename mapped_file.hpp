@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file (POSIX mmap)
+class mapped_file_t
+{
+	public:
+	mapped_file_t(): _data(0), _size(0), _is_open(false) { }
+	~mapped_file_t();
+
+	mapped_file_t(const mapped_file_t &) = delete;
+	mapped_file_t & operator=(const mapped_file_t &) = delete;
+
+	bool open(const std::string & path);
+	void close();
+
+	bool is_open() const;
+	const char * data() const;
+	const char * end() const;
+	size_t size() const;
+
+	private:
+	const char * _data;
+	size_t _size;
+	bool _is_open;
+}; // mapped_file_t
@@ -0,0 +1,80 @@
+#include "ppm_reader.hpp"
+
+#include <cctype> // isspace isdigit
+
+// Skips whitespaces and comments. Comments are allowed between any fields of a header
+static const char * skip_separators(const char * p, const char * end)
+{
+	while(p != end) {
+		if(*p == '#') {
+			while(p != end && *p != '\n') {
+				++p;
+			}
+		} else if( isspace((unsigned char)*p) ) {
+			++p;
+		} else {
+			break;
+		}
+	}
+	return p;
+}
+
+static const char * parse_field(const char * p, const char * end, int & value)
+{
+	p = skip_separators(p, end);
+	if(p == end || !isdigit((unsigned char)*p)) {
+		return 0;
+	}
+	value = 0;
+	while(p != end && isdigit((unsigned char)*p)) {
+		value = value*10 + (*p - '0');
+		if(value > (1 << 24)) {
+			return 0;
+		}
+		++p;
+	}
+	return p;
+}
+
+bool parse_ppm_header(const char * begin, const char * end, int & width, int & height, size_t & header_size)
+{
+	if(end - begin < 2 || begin[0] != 'P' || begin[1] != '6') {
+		return false;
+	}
+	int max_value;
+	const char * p = begin + 2;
+	if( (p = parse_field(p, end, width)) == 0 || (p = parse_field(p, end, height)) == 0 || (p = parse_field(p, end, max_value)) == 0 ) {
+		return false;
+	}
+	// exactly one whitespace separates the header from pixels
+	if(p == end || !isspace((unsigned char)*p) || max_value != 255 || width == 0 || height == 0) {
+		return false;
+	}
+	++p;
+	header_size = p - begin;
+	return (size_t)(end - p) >= (size_t)width * height * 3;
+}
+
+bool ppm_sequence_t::open(const std::vector<std::string> & paths, std::vector<cv::Mat> & frames)
+{
+	close();
+	_files.reset(new mapped_file_t[paths.size()]);
+	frames.resize(paths.size());
+	for(size_t i=0; i<paths.size(); ++i) {
+		mapped_file_t & file = _files[i];
+		int width, height;
+		size_t header_size;
+		if( !file.open(paths[i]) || !parse_ppm_header(file.data(), file.end(), width, height, header_size) ) {
+			close();
+			frames.clear();
+			return false;
+		}
+		frames[i] = cv::Mat(height, width, CV_8UC3, (void*)(file.data() + header_size));
+	}
+	return true;
+}
+
+void ppm_sequence_t::close()
+{
+	_files.reset();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "mapped_file.hpp"
+
+// Parses the header of a raw PPM (P6) image with 8-bit samples. Returns false for other formats or a truncated file,
+// otherwise pixels start at begin + header_size
+bool parse_ppm_header(const char * begin, const char * end, int & width, int & height, size_t & header_size);
+
+// A sequence of raw PPM frames that are memory-mapped instead of being decoded. Frames are matrices over the mappings,
+// so they take no time to load and their pages are read when they are accessed.
+// Pixels are in RGB order and read-only, frames are valid while the sequence is open
+class ppm_sequence_t
+{
+	public:
+	// Returns false if a file cannot be mapped or is not a P6 image with 8-bit samples
+	bool open(const std::vector<std::string> & paths, std::vector<cv::Mat> & frames);
+	void close();
+
+	private:
+	std::unique_ptr<mapped_file_t[]> _files;
+}; // ppm_sequence_t
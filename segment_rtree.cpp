@@ -0,0 +1,343 @@
+#include "segment_rtree.hpp"
+
+#include <algorithm> // sort inplace_merge min max swap
+#include <atomic>
+#include <cmath> // cbrt ceil
+#include <functional>
+#include <thread>
+#include <utility> // pair
+
+bool box3_t::intersects(const box3_t & box) const
+{
+	for(int axis=0; axis<3; ++axis) {
+		if(_max[axis] < box._min[axis] || box._max[axis] < _min[axis]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void box3_t::expand(const box3_t & box)
+{
+	for(int axis=0; axis<3; ++axis) {
+		_min[axis] = std::min(_min[axis], box._min[axis]);
+		_max[axis] = std::max(_max[axis], box._max[axis]);
+	}
+}
+
+// Calls body(0) ... body(amount-1) by num_threads threads
+static void parallel_for(size_t amount, unsigned int num_threads, const std::function<void(size_t)> & body)
+{
+	num_threads = std::min<size_t>(std::max(num_threads, 1u), amount);
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		for(size_t i = next++; i < amount; i = next++) {
+			body(i);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(unsigned int t=1; t<num_threads; ++t) {
+		workers.push_back(std::thread(work));
+	}
+	work();
+	for(std::thread & worker : workers) {
+		worker.join();
+	}
+}
+
+// Compares entries by centers of their boxes along an axis
+template<typename T>
+struct center_less_t
+{
+	explicit center_less_t(int axis): _axis(axis) { }
+	bool operator()(const T & a, const T & b) const {
+		return a._box._min[_axis] + a._box._max[_axis] < b._box._min[_axis] + b._box._max[_axis];
+	}
+	int _axis;
+}; // center_less_t
+
+// Chunks are sorted concurrently, then merged pairwise
+template<typename T>
+static void parallel_sort(std::vector<T> & entries, int axis, unsigned int num_threads)
+{
+	const size_t min_chunk_size = 1 << 14;
+	center_less_t<T> less(axis);
+	size_t amount_of_chunks = std::min<size_t>(num_threads, entries.size() / min_chunk_size);
+	if(amount_of_chunks <= 1) {
+		std::sort(entries.begin(), entries.end(), less);
+		return;
+	}
+
+	std::vector<size_t> bounds(amount_of_chunks+1);
+	for(size_t i=0; i<=amount_of_chunks; ++i) {
+		bounds[i] = entries.size() * i / amount_of_chunks;
+	}
+	parallel_for(amount_of_chunks, num_threads, [&](size_t i) {
+		std::sort(entries.begin() + bounds[i], entries.begin() + bounds[i+1], less);
+	});
+	for(size_t width=1; width<amount_of_chunks; width*=2) {
+		parallel_for((amount_of_chunks + 2*width - 1) / (2*width), num_threads, [&](size_t k) {
+			size_t first = k*2*width;
+			size_t middle = std::min(first + width, amount_of_chunks);
+			size_t last = std::min(first + 2*width, amount_of_chunks);
+			if(middle < last) {
+				std::inplace_merge(entries.begin() + bounds[first], entries.begin() + bounds[middle], entries.begin() + bounds[last], less);
+			}
+		});
+	}
+}
+
+// Orders entries of a level by Sort-Tile-Recursive, so each run of capacity entries makes a compact node
+template<typename T>
+static void sort_tiles(std::vector<T> & entries, size_t capacity, unsigned int num_threads)
+{
+	size_t amount_of_nodes = (entries.size() + capacity - 1) / capacity;
+	size_t amount_of_slabs = std::ceil(std::cbrt((double)amount_of_nodes));
+	size_t run_size = amount_of_slabs * capacity; // a run gives amount_of_slabs nodes
+	size_t slab_size = amount_of_slabs * run_size;
+
+	parallel_sort(entries, 0, num_threads);
+	parallel_for((entries.size() + slab_size - 1) / slab_size, num_threads, [&](size_t slab) {
+		typename std::vector<T>::iterator begin = entries.begin() + slab*slab_size;
+		typename std::vector<T>::iterator end = entries.begin() + std::min(entries.size(), (slab+1)*slab_size);
+		std::sort(begin, end, center_less_t<T>(1));
+		for(typename std::vector<T>::iterator run = begin; run < end; run += std::min<size_t>(run_size, end - run)) {
+			std::sort(run, run + std::min<size_t>(run_size, end - run), center_less_t<T>(2));
+		}
+	});
+}
+
+// Makes nodes of consecutive entries
+template<typename T>
+static void pack(const std::vector<T> & entries, size_t capacity, std::vector<segment_rtree_t::node_t> & nodes)
+{
+	nodes.resize((entries.size() + capacity - 1) / capacity);
+	for(size_t i=0; i<nodes.size(); ++i) {
+		segment_rtree_t::node_t & node = nodes[i];
+		node._first = i*capacity;
+		node._amount = std::min(capacity, entries.size() - node._first);
+		node._box = entries[node._first]._box;
+		for(size_t j=node._first+1; j<node._first+node._amount; ++j) {
+			node._box.expand(entries[j]._box);
+		}
+	}
+}
+
+segment_rtree_t::segment_rtree_t(size_t points_per_piece, size_t node_capacity):
+	_points_per_piece(std::max<size_t>(points_per_piece, 2)), _node_capacity(std::max<size_t>(node_capacity, 2)), _trajectories(0)
+{
+}
+
+void segment_rtree_t::build(const trajectory_store_t & trajectories, size_t last, unsigned int num_threads)
+{
+	clear();
+	_trajectories = &trajectories;
+	if(num_threads == 0) {
+		num_threads = std::thread::hardware_concurrency();
+	}
+
+	// pieces of a trajectory of n points: [0, p), [p-1, 2p-1), ... so that they share their last and first points
+	size_t step = _points_per_piece - 1;
+	std::vector<size_t> offsets(last+1, 0);
+	for(size_t i=0; i<last; ++i) {
+		size_t length = trajectories.length(i);
+		size_t amount = (length <= 1)? length: (length - 1 + step - 1) / step;
+		offsets[i+1] = offsets[i] + amount;
+	}
+	_pieces.resize(offsets.back());
+
+	const size_t block_size = 1024; // trajectories made into pieces by a thread at once
+	parallel_for((last + block_size - 1) / block_size, num_threads, [&](size_t block) {
+		for(size_t i=block*block_size; i<std::min(last, (block+1)*block_size); ++i) {
+			trajectory_store_t::components_t x = trajectories.x(i);
+			trajectory_store_t::components_t y = trajectories.y(i);
+			unsigned int start_frame = trajectories.start_frame(i);
+			for(size_t k=offsets[i]; k<offsets[i+1]; ++k) {
+				piece_t & piece = _pieces[k];
+				piece._trajectory_id = i;
+				piece._first_point = (k - offsets[i]) * step;
+				piece._amount_of_points = std::min(_points_per_piece, x.size() - piece._first_point);
+
+				box3_t & box = piece._box;
+				for(int axis=0; axis<2; ++axis) {
+					box._min[axis] = HUGE_VAL;
+					box._max[axis] = -HUGE_VAL;
+				}
+				for(size_t j=piece._first_point; j<piece._first_point+piece._amount_of_points; ++j) {
+					box._min[0] = std::min<double>(box._min[0], x[j]);
+					box._max[0] = std::max<double>(box._max[0], x[j]);
+					box._min[1] = std::min<double>(box._min[1], y[j]);
+					box._max[1] = std::max<double>(box._max[1], y[j]);
+				}
+				box._min[2] = start_frame + piece._first_point;
+				box._max[2] = start_frame + piece._first_point + piece._amount_of_points - 1;
+			}
+		}
+	});
+	if( _pieces.empty() ) {
+		return;
+	}
+
+	sort_tiles(_pieces, _node_capacity, num_threads);
+	_levels.push_back(std::vector<node_t>());
+	pack(_pieces, _node_capacity, _levels.back());
+	while(_levels.back().size() > _node_capacity) {
+		sort_tiles(_levels.back(), _node_capacity, num_threads);
+		std::vector<node_t> parents;
+		pack(_levels.back(), _node_capacity, parents);
+		_levels.push_back(std::vector<node_t>());
+		_levels.back().swap(parents);
+	}
+}
+
+void segment_rtree_t::clear()
+{
+	_trajectories = 0;
+	_pieces.clear();
+	_levels.clear();
+}
+
+template<typename visitor_t>
+void segment_rtree_t::search(const box3_t & box, visitor_t visit) const
+{
+	if( _levels.empty() ) {
+		return;
+	}
+	std::vector<std::pair<size_t, size_t> > stack; // level and index of a node
+	for(size_t i=0; i<_levels.back().size(); ++i) {
+		stack.push_back(std::make_pair(_levels.size()-1, i));
+	}
+	while( !stack.empty() ) {
+		size_t level = stack.back().first;
+		const node_t & node = _levels[level][stack.back().second];
+		stack.pop_back();
+		if( !node._box.intersects(box) ) {
+			continue;
+		}
+		for(size_t child=node._first; child<node._first+node._amount; ++child) {
+			if(level > 0) {
+				stack.push_back(std::make_pair(level-1, child));
+			} else if( _pieces[child]._box.intersects(box) ) {
+				visit(_pieces[child]);
+			}
+		}
+	}
+}
+
+// Clips the segment a-b by slabs of the box
+static bool segment_intersects(const double a[3], const double b[3], const box3_t & box)
+{
+	double t_min = 0;
+	double t_max = 1;
+	for(int axis=0; axis<3; ++axis) {
+		double d = b[axis] - a[axis];
+		if(d == 0) {
+			if(a[axis] < box._min[axis] || a[axis] > box._max[axis]) {
+				return false;
+			}
+			continue;
+		}
+		double t0 = (box._min[axis] - a[axis]) / d;
+		double t1 = (box._max[axis] - a[axis]) / d;
+		if(t0 > t1) {
+			std::swap(t0, t1);
+		}
+		t_min = std::max(t_min, t0);
+		t_max = std::min(t_max, t1);
+		if(t_min > t_max) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Sign of the cross product (q - p) x (r - p)
+static int orientation(const cv::Point2d & p, const cv::Point2d & q, const cv::Point2d & r)
+{
+	double cross = (q.x - p.x)*(r.y - p.y) - (q.y - p.y)*(r.x - p.x);
+	return (cross > 0) - (cross < 0);
+}
+
+// r is collinear with p-q, is it within the segment
+static bool is_within(const cv::Point2d & p, const cv::Point2d & q, const cv::Point2d & r)
+{
+	return std::min(p.x, q.x) <= r.x && r.x <= std::max(p.x, q.x) && std::min(p.y, q.y) <= r.y && r.y <= std::max(p.y, q.y);
+}
+
+static bool segments_intersect(const cv::Point2d & p1, const cv::Point2d & p2, const cv::Point2d & q1, const cv::Point2d & q2)
+{
+	int o1 = orientation(p1, p2, q1);
+	int o2 = orientation(p1, p2, q2);
+	int o3 = orientation(q1, q2, p1);
+	int o4 = orientation(q1, q2, p2);
+	if(o1 != o2 && o3 != o4) {
+		return true;
+	}
+	return (o1 == 0 && is_within(p1, p2, q1)) || (o2 == 0 && is_within(p1, p2, q2)) ||
+		(o3 == 0 && is_within(q1, q2, p1)) || (o4 == 0 && is_within(q1, q2, p2));
+}
+
+// Sorts ids and removes duplicates
+static void unique_ids(std::vector<size_t> & ids)
+{
+	std::sort(ids.begin(), ids.end());
+	ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+void segment_rtree_t::query(const box3_t & box, std::vector<size_t> & ids) const
+{
+	ids.clear();
+	search(box, [&](const piece_t & piece) {
+		trajectory_store_t::components_t x = _trajectories->x(piece._trajectory_id);
+		trajectory_store_t::components_t y = _trajectories->y(piece._trajectory_id);
+		double start_frame = _trajectories->start_frame(piece._trajectory_id);
+		size_t last_point = piece._first_point + piece._amount_of_points - 1;
+		for(size_t j=piece._first_point; j==piece._first_point || j<last_point; ++j) {
+			size_t next = std::min(j+1, last_point); // a piece of a single point is a segment of zero length
+			double a[3] = {x[j], y[j], start_frame + j};
+			double b[3] = {x[next], y[next], start_frame + next};
+			if( segment_intersects(a, b, box) ) {
+				ids.push_back(piece._trajectory_id);
+				return;
+			}
+		}
+	});
+	unique_ids(ids);
+}
+
+void segment_rtree_t::crossing(const std::vector<cv::Point2d> & polyline, unsigned int first_frame, unsigned int last_frame,
+		std::vector<size_t> & ids) const
+{
+	ids.clear();
+	for(size_t k=1; k<polyline.size(); ++k) {
+		const cv::Point2d & q1 = polyline[k-1];
+		const cv::Point2d & q2 = polyline[k];
+		box3_t box = {{std::min(q1.x, q2.x), std::min(q1.y, q2.y), (double)first_frame},
+			{std::max(q1.x, q2.x), std::max(q1.y, q2.y), (double)last_frame}};
+		search(box, [&](const piece_t & piece) {
+			trajectory_store_t::components_t x = _trajectories->x(piece._trajectory_id);
+			trajectory_store_t::components_t y = _trajectories->y(piece._trajectory_id);
+			unsigned int start_frame = _trajectories->start_frame(piece._trajectory_id);
+			for(size_t j=piece._first_point; j+1<piece._first_point+piece._amount_of_points; ++j) {
+				if(start_frame + j < first_frame || start_frame + j + 1 > last_frame) {
+					continue;
+				}
+				if( segments_intersect(cv::Point2d(x[j], y[j]), cv::Point2d(x[j+1], y[j+1]), q1, q2) ) {
+					ids.push_back(piece._trajectory_id);
+					return;
+				}
+			}
+		});
+	}
+	unique_ids(ids);
+}
+
+size_t segment_rtree_t::memory() const
+{
+	size_t bytes = _pieces.capacity() * sizeof(piece_t);
+	for(const std::vector<node_t> & level : _levels) {
+		bytes += level.capacity() * sizeof(node_t);
+	}
+	return bytes;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "trajectory_store.hpp"
+
+// An axis-aligned box in (x, y, t). Bounds are included
+struct box3_t
+{
+	double _min[3];
+	double _max[3];
+
+	bool intersects(const box3_t & box) const;
+	void expand(const box3_t & box);
+}; // box3_t
+
+// An R-tree over pieces of trajectories in (x, y, t) for spatio-temporal queries: which trajectories pass through a region
+// between two frames or cross a line. A piece is a few consecutive points (neighbour pieces share a point, so every segment
+// btw consecutive points is in a piece). The tree is bulk-loaded by Sort-Tile-Recursive packing: entries of a level are sorted
+// by x into slabs, slabs by y into runs, runs by t, then consecutive entries become nodes of the next level.
+// Pieces are made and slabs are sorted by all cores. Boxes prune the search, then segments of pieces are tested exactly
+class segment_rtree_t
+{
+	public:
+	explicit segment_rtree_t(size_t points_per_piece = 8, size_t node_capacity = 16);
+
+	// Indexes trajectories [0, last). The store must outlive the tree and not change until the next build
+	void build(const trajectory_store_t & trajectories, size_t last, unsigned int num_threads = 0);
+	void clear();
+
+	// Ids of trajectories, ascending, whose path (points joined by segments) intersects the box
+	void query(const box3_t & box, std::vector<size_t> & ids) const;
+	// Ids of trajectories, ascending, whose path in the image crosses the polyline by a segment btw two points of
+	// frames [first_frame, last_frame]
+	void crossing(const std::vector<cv::Point2d> & polyline, unsigned int first_frame, unsigned int last_frame,
+			std::vector<size_t> & ids) const;
+
+	size_t amount_of_pieces() const { return _pieces.size(); }
+	size_t memory() const; // bytes taken by the tree
+
+	struct piece_t
+	{
+		box3_t _box;
+		unsigned int _trajectory_id;
+		unsigned int _first_point;
+		unsigned int _amount_of_points;
+	}; // piece_t
+
+	struct node_t
+	{
+		box3_t _box;
+		size_t _first; // children are [_first, _first + _amount) of the level below, or of pieces
+		size_t _amount;
+	}; // node_t
+
+	private:
+	// Calls visit(piece) for pieces whose boxes intersect the box
+	template<typename visitor_t>
+	void search(const box3_t & box, visitor_t visit) const;
+
+	size_t _points_per_piece;
+	size_t _node_capacity;
+	const trajectory_store_t * _trajectories;
+
+	std::vector<piece_t> _pieces;
+	std::vector<std::vector<node_t> > _levels; // _levels[0] are leaves over pieces, the last level is not larger than a node
+}; // segment_rtree_t
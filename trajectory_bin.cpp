@@ -0,0 +1,228 @@
+#include "trajectory_bin.hpp"
+#include <cassert>
+#include <cstring> // memcmp memcpy
+#include <algorithm> // copy min
+#include "block_writer.hpp"
+
+static const char trb_magic[4] = { 'T', 'R', 'B', '1' };
+
+static size_t align8(size_t size)
+{
+	return (size + 7) & ~size_t(7);
+}
+
+bool trajectory_bin_t::open(const std::string & path)
+{
+	if( !_file.open(path) ) {
+		return false;
+	}
+	if( _file.size() < sizeof(trajectory_bin_header_t) ) {
+		close();
+		return false;
+	}
+	_header = (const trajectory_bin_header_t*)_file.data();
+	if( memcmp(_header->magic, trb_magic, sizeof(trb_magic)) != 0 ) {
+		close();
+		return false;
+	}
+
+	// Sizes of sections are products of the amounts, so the amounts are bounded by the file size before they are used
+	uint64_t n = _header->amount_of_trajectories;
+	uint64_t m = _header->amount_of_points;
+	if( n >= _file.size()/(2*sizeof(int32_t) + sizeof(uint32_t) + sizeof(uint64_t)) || m > _file.size()/(2*sizeof(double)) ) {
+		close();
+		return false;
+	}
+	size_t pos = align8(sizeof(trajectory_bin_header_t));
+	size_t start_frames_pos = pos; pos += align8(n*sizeof(int32_t));
+	size_t lengths_pos = pos; pos += align8(n*sizeof(uint32_t));
+	size_t labels_pos = pos; pos += align8(n*sizeof(int32_t));
+	size_t offsets_pos = pos; pos += (n+1)*sizeof(uint64_t);
+	size_t x_pos = pos; pos += m*sizeof(double);
+	size_t y_pos = pos; pos += m*sizeof(double);
+	if( pos != _file.size() ) {
+		close();
+		return false;
+	}
+
+	_start_frames = (const int32_t*)(_file.data() + start_frames_pos);
+	_lengths = (const uint32_t*)(_file.data() + lengths_pos);
+	_labels = (const int32_t*)(_file.data() + labels_pos);
+	_offsets = (const uint64_t*)(_file.data() + offsets_pos);
+	_x = (const double*)(_file.data() + x_pos);
+	_y = (const double*)(_file.data() + y_pos);
+
+	// Offsets must start from 0, end at m and correspond to lengths, otherwise x(i) and y(i) would point out of the columns
+	if( _offsets[0] != 0 || _offsets[n] != m ) {
+		close();
+		return false;
+	}
+	for(size_t i=0; i<n; ++i) {
+		if( _offsets[i+1] < _offsets[i] || _offsets[i+1] - _offsets[i] != _lengths[i] ) {
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void trajectory_bin_t::close()
+{
+	_file.close();
+	_header = 0;
+}
+
+int trajectory_bin_t::video_length() const
+{
+	return _header->video_length;
+}
+
+size_t trajectory_bin_t::size() const
+{
+	return _header->amount_of_trajectories;
+}
+
+size_t trajectory_bin_t::amount_of_points() const
+{
+	return _header->amount_of_points;
+}
+
+int trajectory_bin_t::start_frame(size_t i) const
+{
+	return _start_frames[i];
+}
+
+size_t trajectory_bin_t::length(size_t i) const
+{
+	return _lengths[i];
+}
+
+int trajectory_bin_t::label(size_t i) const
+{
+	return _labels[i];
+}
+
+size_t trajectory_bin_t::offset(size_t i) const
+{
+	return _offsets[i];
+}
+
+const double * trajectory_bin_t::x(size_t i) const
+{
+	return _x + _offsets[i];
+}
+
+const double * trajectory_bin_t::y(size_t i) const
+{
+	return _y + _offsets[i];
+}
+
+void trajectory_bin_t::get(size_t i, trajectory_t & tr) const
+{
+	assert(i < size());
+
+	const double * x_i = x(i);
+	const double * y_i = y(i);
+	tr.recreate(length(i), start_frame(i));
+	for(size_t j=0; j<tr.size(); ++j) {
+		tr[j].x = x_i[j];
+		tr[j].y = y_i[j];
+	}
+}
+
+template<typename T>
+static void write_column(const std::vector<T> & column, block_writer_t & out)
+{
+	static const char padding[8] = { 0 };
+	size_t bytes = column.size()*sizeof(T);
+	out.put_raw(column.data(), bytes);
+	out.put_raw(padding, align8(bytes) - bytes);
+}
+
+// Coordinates are always written as doubles
+static void write_double_column(const std::vector<double> & column, block_writer_t & out)
+{
+	write_column(column, out);
+}
+template<typename T>
+static void write_double_column(const std::vector<T> & column, block_writer_t & out)
+{
+	for(const T & value : column) {
+		double d = value;
+		out.put_raw(&d, sizeof(d));
+	}
+}
+
+bool save_trajectories_bin(const std::string & path, int video_length, const trajectory_store_t & trajectories, const std::vector<int> & labels)
+{
+	assert(labels.empty() || labels.size() == trajectories.size());
+
+	size_t n = trajectories.size();
+	std::vector<int32_t> start_frames(trajectories._start_frames.begin(), trajectories._start_frames.end());
+	std::vector<uint32_t> lengths(n);
+	std::vector<int32_t> labels_column(n, 0);
+	std::vector<uint64_t> offsets(trajectories._offsets.begin(), trajectories._offsets.end());
+	for(size_t i=0; i<n; ++i) {
+		lengths[i] = trajectories.length(i);
+		if( !labels.empty() ) {
+			labels_column[i] = labels[i];
+		}
+	}
+
+	trajectory_bin_header_t header;
+	memcpy(header.magic, trb_magic, sizeof(trb_magic));
+	header.video_length = video_length;
+	header.amount_of_trajectories = n;
+	header.amount_of_points = trajectories.amount_of_points();
+
+	block_writer_t out;
+	if( !out.open(path) ) {
+		return false;
+	}
+	out.put_raw(&header, sizeof(header));
+	write_column(start_frames, out);
+	write_column(lengths, out);
+	write_column(labels_column, out);
+	write_column(offsets, out);
+	write_double_column(trajectories._x, out);
+	write_double_column(trajectories._y, out);
+	return out.close();
+}
+
+static bool load_trajectories_bin(const std::string & path, int & video_length, trajectory_store_t & trajectories, std::vector<int> * labels)
+{
+	trajectory_bin_t bin;
+	if( !bin.open(path) ) {
+		return false;
+	}
+	video_length = bin.video_length();
+
+	std::vector<size_t> lengths(bin.size());
+	for(size_t i=0; i<bin.size(); ++i) {
+		lengths[i] = bin.length(i);
+	}
+	trajectories.recreate(lengths);
+	for(size_t i=0; i<bin.size(); ++i) {
+		trajectories._start_frames[i] = bin.start_frame(i);
+	}
+	size_t m = std::min(bin.amount_of_points(), trajectories._x.size());
+	std::copy(bin.x(0), bin.x(0) + m, trajectories._x.begin());
+	std::copy(bin.y(0), bin.y(0) + m, trajectories._y.begin());
+	if(labels != 0) {
+		labels->resize(bin.size());
+		for(size_t i=0; i<bin.size(); ++i) {
+			(*labels)[i] = bin.label(i);
+		}
+	}
+	return true;
+}
+
+bool load_trajectories_bin(const std::string & path, int & video_length, trajectory_store_t & trajectories)
+{
+	return load_trajectories_bin(path, video_length, trajectories, 0);
+}
+
+bool load_trajectories_bin(const std::string & path, int & video_length, trajectory_store_t & trajectories, std::vector<int> & labels)
+{
+	return load_trajectories_bin(path, video_length, trajectories, &labels);
+}
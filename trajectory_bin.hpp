@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "trajectory_t.hpp"
+#include "trajectory_store.hpp"
+#include "mapped_file.hpp"
+
+// Binary columnar container of trajectories (.trb). All values are in native byte order.
+//	header
+//	int32_t  start_frame[n]
+//	uint32_t length[n]
+//	int32_t  label[n]
+//	uint64_t offset[n+1]	index of the first point of each trajectory in the x and y columns
+//	double   x[m]
+//	double   y[m]
+// n is amount_of_trajectories and m is amount_of_points. Every section starts at a multiple of 8 bytes.
+struct trajectory_bin_header_t
+{
+	char magic[4]; // "TRB1"
+	int32_t video_length;
+	uint64_t amount_of_trajectories;
+	uint64_t amount_of_points;
+}; // trajectory_bin_header_t
+
+// Random access to a memory-mapped .trb file. Trajectory N is available without scanning
+class trajectory_bin_t
+{
+	public:
+	trajectory_bin_t(): _header(0) { }
+
+	// Returns false if the file cannot be mapped, is truncated or its offsets do not match lengths of trajectories
+	bool open(const std::string & path);
+	void close();
+
+	int video_length() const;
+	size_t size() const;
+	size_t amount_of_points() const;
+
+	int start_frame(size_t i) const;
+	size_t length(size_t i) const;
+	int label(size_t i) const;
+	size_t offset(size_t i) const; // first point of i-th trajectory
+	const double * x(size_t i) const;
+	const double * y(size_t i) const;
+
+	void get(size_t i, trajectory_t & tr) const;
+
+	private:
+	mapped_file_t _file;
+	const trajectory_bin_header_t * _header;
+	const int32_t * _start_frames;
+	const uint32_t * _lengths;
+	const int32_t * _labels;
+	const uint64_t * _offsets;
+	const double * _x;
+	const double * _y;
+}; // trajectory_bin_t
+
+// Return false if a file cannot be opened or is malformed.
+// labels may be empty, then all labels are written as 0
+bool save_trajectories_bin(const std::string & path, int video_length, const trajectory_store_t & trajectories, const std::vector<int> & labels);
+// Columns of the file are copied into the store, converted to trajectory_t::component_t
+bool load_trajectories_bin(const std::string & path, int & video_length, trajectory_store_t & trajectories);
+bool load_trajectories_bin(const std::string & path, int & video_length, trajectory_store_t & trajectories, std::vector<int> & labels);
@@ -0,0 +1,265 @@
+#include "trajectory_codec.hpp"
+#include "block_writer.hpp"
+#include <cassert>
+#include <cmath> // ldexp llround
+#include <cstring> // memcmp
+
+static const char trz_magic[4] = { 'T', 'R', 'Z', '1' };
+static const uint64_t min_block_bytes = 4;
+
+static uint64_t zigzag(int64_t value)
+{
+	return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value)
+{
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static void put_varint(uint64_t value, std::vector<uint8_t> & out)
+{
+	while(value >= 0x80) {
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+static bool get_varint(const uint8_t * & pos, const uint8_t * end, uint64_t & value)
+{
+	value = 0;
+	for(int shift=0; pos != end && shift < 64; shift += 7) {
+		uint8_t byte = *pos++;
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		if( (byte & 0x80) == 0 ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Reads a varint byte by byte from a stream
+static bool get_varint(std::istream & in, uint64_t & value)
+{
+	value = 0;
+	for(int shift=0; shift < 64; shift += 7) {
+		int byte = in.get();
+		if(byte == std::char_traits<char>::eof()) {
+			return false;
+		}
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		if( (byte & 0x80) == 0 ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static int64_t quantize(double value, int fractional_bits)
+{
+	return llround(ldexp(value, fractional_bits));
+}
+
+bool trajectory_decoder_t::open(const std::string & path)
+{
+	_in.open(path, std::ios::binary);
+	if( !_in.is_open() ) {
+		return false;
+	}
+	_in.seekg(0, std::ios::end);
+	_file_size = _in.tellg();
+	_in.seekg(0, std::ios::beg);
+
+	char magic[sizeof(trz_magic)];
+	_in.read(magic, sizeof(magic));
+	if( !_in || memcmp(magic, trz_magic, sizeof(trz_magic)) != 0 ) {
+		return false;
+	}
+
+	uint64_t video_length, size, fractional_bits;
+	if( !get_varint(_in, video_length) || !get_varint(_in, size) || !get_varint(_in, fractional_bits) ) {
+		return false;
+	}
+	_video_length = unzigzag(video_length);
+	_size = size;
+	_fractional_bits = fractional_bits;
+	_amount_read = 0;
+	// sizes read from the file are checked against the bytes left before buffers are allocated for them.
+	// A block takes at least 4 bytes: its size, label, length and start frame
+	return fractional_bits < 32 && size <= bytes_left() / min_block_bytes;
+}
+
+uint64_t trajectory_decoder_t::bytes_left()
+{
+	std::streamoff position = _in.tellg();
+	return (position < 0 || (uint64_t)position > _file_size)? 0: _file_size - position;
+}
+
+bool trajectory_decoder_t::read_block()
+{
+	if(_amount_read == _size) {
+		return false;
+	}
+	uint64_t block_size;
+	if( !get_varint(_in, block_size) || block_size > bytes_left() ) {
+		return false;
+	}
+	_block.resize(block_size);
+	_in.read((char*)_block.data(), block_size);
+	if( (uint64_t)_in.gcount() != block_size ) {
+		return false;
+	}
+	++_amount_read;
+	return true;
+}
+
+// Decodes a block into x and y. Store and trajectory_t versions of next() share it
+template<typename Output>
+static bool decode_block(const std::vector<uint8_t> & block, int fractional_bits, int & label, Output output)
+{
+	const uint8_t * pos = block.data();
+	const uint8_t * end = pos + block.size();
+
+	uint64_t label_code, length, start_frame;
+	if( !get_varint(pos, end, label_code) || !get_varint(pos, end, length) || !get_varint(pos, end, start_frame) ) {
+		return false;
+	}
+	label = unzigzag(label_code);
+	if(length > (uint64_t)(end - pos) / 2) { // every point takes at least two bytes
+		return false;
+	}
+
+	trajectory_t::component_t * x;
+	trajectory_t::component_t * y;
+	output(length, start_frame, x, y);
+
+	int64_t qx = 0, qy = 0;
+	for(uint64_t j=0; j<length; ++j) {
+		uint64_t dx, dy;
+		if( !get_varint(pos, end, dx) || !get_varint(pos, end, dy) ) {
+			return false;
+		}
+		qx += unzigzag(dx);
+		qy += unzigzag(dy);
+		x[j] = ldexp((double)qx, -fractional_bits);
+		y[j] = ldexp((double)qy, -fractional_bits);
+	}
+	return pos == end;
+}
+
+bool trajectory_decoder_t::next(trajectory_t & tr, int & label)
+{
+	if( !read_block() ) {
+		return false;
+	}
+	std::vector<trajectory_t::component_t> x, y;
+	bool is_ok = decode_block(_block, _fractional_bits, label,
+		[&](size_t length, unsigned int start_frame, trajectory_t::component_t * & px, trajectory_t::component_t * & py) {
+			tr.recreate(length, start_frame);
+			x.resize(length);
+			y.resize(length);
+			px = x.data();
+			py = y.data();
+		});
+	if( !is_ok ) {
+		return false; // tr may keep its previous size while x and y are empty
+	}
+	for(size_t j=0; j<tr.size(); ++j) {
+		tr[j].x = x[j];
+		tr[j].y = y[j];
+	}
+	return true;
+}
+
+bool trajectory_decoder_t::next(trajectory_store_t & trajectories, int & label)
+{
+	if( !read_block() ) {
+		return false;
+	}
+	return decode_block(_block, _fractional_bits, label,
+		[&](size_t length, unsigned int start_frame, trajectory_t::component_t * & px, trajectory_t::component_t * & py) {
+			size_t i = trajectories.append(length, start_frame);
+			px = trajectories._x.data() + trajectories._offsets[i];
+			py = trajectories._y.data() + trajectories._offsets[i];
+		});
+}
+
+bool save_trajectories_trz(const std::string & path, int video_length, const trajectory_store_t & trajectories,
+		const std::vector<int> & labels, int fractional_bits)
+{
+	assert(labels.empty() || labels.size() == trajectories.size());
+	assert(fractional_bits >= 0 && fractional_bits < 32);
+
+	block_writer_t out;
+	if( !out.open(path) ) {
+		return false;
+	}
+
+	std::vector<uint8_t> bytes;
+	out.put_raw(trz_magic, sizeof(trz_magic));
+	put_varint(zigzag(video_length), bytes);
+	put_varint(trajectories.size(), bytes);
+	put_varint(fractional_bits, bytes);
+	out.put_raw(bytes.data(), bytes.size());
+
+	std::vector<uint8_t> block;
+	for(size_t i=0; i<trajectories.size(); ++i) {
+		block.clear();
+		put_varint(zigzag(labels.empty()? 0: labels[i]), block);
+		put_varint(trajectories.length(i), block);
+		put_varint(trajectories.start_frame(i), block);
+
+		trajectory_store_t::components_t x = trajectories.x(i);
+		trajectory_store_t::components_t y = trajectories.y(i);
+		int64_t previous_x = 0, previous_y = 0;
+		for(size_t j=0; j<x.size(); ++j) {
+			int64_t qx = quantize(x[j], fractional_bits);
+			int64_t qy = quantize(y[j], fractional_bits);
+			put_varint(zigzag(qx - previous_x), block);
+			put_varint(zigzag(qy - previous_y), block);
+			previous_x = qx;
+			previous_y = qy;
+		}
+
+		bytes.clear();
+		put_varint(block.size(), bytes);
+		out.put_raw(bytes.data(), bytes.size());
+		out.put_raw(block.data(), block.size());
+	}
+	return out.close();
+}
+
+static bool load_trajectories_trz(const std::string & path, int & video_length, trajectory_store_t & trajectories, std::vector<int> * labels)
+{
+	trajectory_decoder_t decoder;
+	if( !decoder.open(path) ) {
+		return false;
+	}
+	video_length = decoder.video_length();
+
+	trajectories.clear();
+	if(labels != 0) {
+		labels->resize(decoder.size());
+	}
+	int label;
+	for(size_t i=0; i<decoder.size(); ++i) {
+		if( !decoder.next(trajectories, label) ) {
+			return false;
+		}
+		if(labels != 0) {
+			(*labels)[i] = label;
+		}
+	}
+	return true;
+}
+
+bool load_trajectories_trz(const std::string & path, int & video_length, trajectory_store_t & trajectories)
+{
+	return load_trajectories_trz(path, video_length, trajectories, 0);
+}
+
+bool load_trajectories_trz(const std::string & path, int & video_length, trajectory_store_t & trajectories, std::vector<int> & labels)
+{
+	return load_trajectories_trz(path, video_length, trajectories, &labels);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "trajectory_t.hpp"
+#include "trajectory_store.hpp"
+
+// Compressed trajectory container (.trz). Coordinates are quantized to 1/2^fractional_bits px and
+// stored as variable-length (LEB128) zigzag integers: the first point of a trajectory as it is and
+// every other point as the difference to the previous one. Layout:
+//	"TRZ1" video_length amount_of_trajectories fractional_bits
+//	block_size label length start_frame x_0 y_0 dx_1 dy_1 ... dx_n-1 dy_n-1
+//	...
+// Every field is a varint. block_size is the amount of bytes after it, so a block can be skipped.
+
+// Reads a .trz file block by block, without loading the whole file
+class trajectory_decoder_t
+{
+	public:
+	trajectory_decoder_t(): _file_size(0), _video_length(0), _size(0), _fractional_bits(0), _amount_read(0) { }
+
+	// Returns false if the file cannot be opened or its header is malformed, e.g. it has more trajectories than bytes
+	bool open(const std::string & path);
+
+	int video_length() const { return _video_length; }
+	size_t size() const { return _size; } // amount of trajectories
+	int fractional_bits() const { return _fractional_bits; }
+
+	// Decodes the next trajectory. Returns false at the end of file or if the file is malformed
+	bool next(trajectory_t & tr, int & label);
+	// Same, but appends the trajectory to the store
+	bool next(trajectory_store_t & trajectories, int & label);
+
+	private:
+	bool read_block();
+	uint64_t bytes_left();
+
+	std::ifstream _in;
+	uint64_t _file_size;
+	std::vector<uint8_t> _block;
+	int _video_length;
+	size_t _size;
+	int _fractional_bits;
+	size_t _amount_read;
+}; // trajectory_decoder_t
+
+const int default_fractional_bits = 8; // 1/256 px
+
+// Return false if a file cannot be opened or is malformed.
+// labels may be empty, then all labels are written as 0
+bool save_trajectories_trz(const std::string & path, int video_length, const trajectory_store_t & trajectories,
+		const std::vector<int> & labels, int fractional_bits = default_fractional_bits);
+bool load_trajectories_trz(const std::string & path, int & video_length, trajectory_store_t & trajectories);
+bool load_trajectories_trz(const std::string & path, int & video_length, trajectory_store_t & trajectories, std::vector<int> & labels);
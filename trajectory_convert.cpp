@@ -0,0 +1,42 @@
+// Converts trajectories between the text .dat format, the binary columnar .trb container, which
+// can be memory-mapped by the viewer and other tools without parsing, and the compressed .trz container
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "trajectory_store.hpp"
+#include "trajectory_io.hpp"
+
+int main(int argc, char * argv[])
+{
+	if(argc!=1+2) {
+		std::cout << "Usage: " << argv[0] << " <path_to_input> <path_to_output>" << std::endl;
+		std::cout << "Both files are .dat, .trb or .trz" << std::endl;
+		return 1;
+	}
+
+	std::string path_to_input(argv[1]);
+	if( !is_trajectory_file(path_to_input) ) {
+		std::cout << path_to_input << " must be a .dat, .trb or .trz file" << std::endl;
+		return 1;
+	}
+
+	std::string path_to_output(argv[2]);
+	if( !is_trajectory_file(path_to_output) ) {
+		std::cout << path_to_output << " must be a .dat, .trb or .trz file" << std::endl;
+		return 1;
+	}
+
+	int video_length;
+	trajectory_store_t trajectories;
+	std::vector<int> labels;
+	if( !load_trajectory_file(path_to_input, video_length, trajectories, labels) ) {
+		std::cout << "Cannot read " << path_to_input << std::endl;
+		return 1;
+	}
+	if( !save_trajectory_file(path_to_output, video_length, trajectories, labels) ) {
+		std::cout << "Cannot write " << path_to_output << std::endl;
+		return 1;
+	}
+	return 0;
+}
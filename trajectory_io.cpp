@@ -0,0 +1,62 @@
+#include "trajectory_io.hpp"
+#include "dat_reader.hpp"
+#include "dat_writer.hpp"
+#include "trajectory_bin.hpp"
+#include "trajectory_codec.hpp"
+
+static std::string extension(const std::string & path)
+{
+	size_t dot = path.find_last_of(".");
+	return (dot == std::string::npos)? std::string(): path.substr(dot);
+}
+
+bool is_trajectory_file(const std::string & path)
+{
+	std::string ext = extension(path);
+	return ext == ".dat" || ext == ".trb" || ext == ".trz";
+}
+
+bool load_trajectory_file(const std::string & path, int & video_length, trajectory_store_t & trajectories, std::vector<int> & labels)
+{
+	std::string ext = extension(path);
+	if(ext == ".dat") {
+		return load_trajectories(path, video_length, trajectories, labels);
+	}
+	if(ext == ".trb") {
+		return load_trajectories_bin(path, video_length, trajectories, labels);
+	}
+	if(ext == ".trz") {
+		return load_trajectories_trz(path, video_length, trajectories, labels);
+	}
+	return false;
+}
+
+bool load_trajectory_file(const std::string & path, int & video_length, trajectory_store_t & trajectories)
+{
+	std::string ext = extension(path);
+	if(ext == ".dat") {
+		return load_trajectories(path, video_length, trajectories);
+	}
+	if(ext == ".trb") {
+		return load_trajectories_bin(path, video_length, trajectories);
+	}
+	if(ext == ".trz") {
+		return load_trajectories_trz(path, video_length, trajectories);
+	}
+	return false;
+}
+
+bool save_trajectory_file(const std::string & path, int video_length, const trajectory_store_t & trajectories, const std::vector<int> & labels)
+{
+	std::string ext = extension(path);
+	if(ext == ".dat") {
+		return save_trajectories(path, video_length, trajectories, labels);
+	}
+	if(ext == ".trb") {
+		return save_trajectories_bin(path, video_length, trajectories, labels);
+	}
+	if(ext == ".trz") {
+		return save_trajectories_trz(path, video_length, trajectories, labels);
+	}
+	return false;
+}
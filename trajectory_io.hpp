@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "trajectory_store.hpp"
+
+// Trajectory files in any supported format, selected by extension:
+//	.dat	text, see README.txt
+//	.trb	binary columnar container, see trajectory_bin.hpp
+//	.trz	delta/varint compressed container, see trajectory_codec.hpp
+
+bool is_trajectory_file(const std::string & path);
+
+// Return false if a file cannot be opened or is malformed. All formats keep labels
+bool load_trajectory_file(const std::string & path, int & video_length, trajectory_store_t & trajectories, std::vector<int> & labels);
+bool load_trajectory_file(const std::string & path, int & video_length, trajectory_store_t & trajectories);
+// labels may be empty, then all labels are written as 0
+bool save_trajectory_file(const std::string & path, int video_length, const trajectory_store_t & trajectories, const std::vector<int> & labels);
@@ -0,0 +1,190 @@
+#include "trajectory_picker.hpp"
+
+#include <algorithm> // nth_element push_heap pop_heap sort_heap sort unique min max
+
+const int trajectory_picker_t::not_found;
+
+void point_kd_tree_t::build(frame_index_t::frame_points_t points)
+{
+	_nodes.resize(points.size());
+	for(size_t i=0; i<points.size(); ++i) {
+		_nodes[i]._x = points[i]._x;
+		_nodes[i]._y = points[i]._y;
+		_nodes[i]._point_id = i;
+	}
+	build(0, _nodes.size(), 0);
+}
+
+void point_kd_tree_t::build(size_t first, size_t last, int depth)
+{
+	if(last - first <= 1) {
+		return;
+	}
+	size_t middle = first + (last - first)/2;
+	if(depth % 2 == 0) {
+		std::nth_element(_nodes.begin() + first, _nodes.begin() + middle, _nodes.begin() + last,
+				[](const node_t & a, const node_t & b) { return a._x < b._x; });
+	} else {
+		std::nth_element(_nodes.begin() + first, _nodes.begin() + middle, _nodes.begin() + last,
+				[](const node_t & a, const node_t & b) { return a._y < b._y; });
+	}
+	build(first, middle, depth+1);
+	build(middle+1, last, depth+1);
+}
+
+void point_kd_tree_t::nearest(double x, double y, double radius, size_t k, std::vector<std::pair<double, unsigned int> > & out) const
+{
+	out.clear();
+	if(k == 0) {
+		return;
+	}
+	double max_distance = radius*radius;
+	search(0, _nodes.size(), 0, x, y, max_distance, k, out);
+	std::sort_heap(out.begin(), out.end());
+}
+
+// heap is a max-heap of the best points found so far. max_distance is the squared radius until k points are found,
+// then the distance to the worst of them
+void point_kd_tree_t::search(size_t first, size_t last, int depth, double x, double y, double & max_distance, size_t k,
+		std::vector<std::pair<double, unsigned int> > & heap) const
+{
+	if(first >= last) {
+		return;
+	}
+	size_t middle = first + (last - first)/2;
+	const node_t & node = _nodes[middle];
+	double dx = node._x - x;
+	double dy = node._y - y;
+	double distance = dx*dx + dy*dy;
+	if(distance <= max_distance) {
+		heap.push_back(std::make_pair(distance, node._point_id));
+		std::push_heap(heap.begin(), heap.end());
+		if(heap.size() > k) {
+			std::pop_heap(heap.begin(), heap.end());
+			heap.pop_back();
+		}
+		if(heap.size() == k) {
+			max_distance = heap.front().first;
+		}
+	}
+
+	double split = (depth % 2 == 0)? -dx: -dy; // signed distance from the splitting line to the query
+	bool is_before = split < 0;
+	if(is_before) {
+		search(first, middle, depth+1, x, y, max_distance, k, heap);
+	} else {
+		search(middle+1, last, depth+1, x, y, max_distance, k, heap);
+	}
+	if(split*split <= max_distance) { // the other side may be closer than the current worst
+		if(is_before) {
+			search(middle+1, last, depth+1, x, y, max_distance, k, heap);
+		} else {
+			search(first, middle, depth+1, x, y, max_distance, k, heap);
+		}
+	}
+}
+
+void point_kd_tree_t::inside(double min_x, double min_y, double max_x, double max_y, std::vector<unsigned int> & out) const
+{
+	out.clear();
+	double min[2] = {min_x, min_y};
+	double max[2] = {max_x, max_y};
+	inside(0, _nodes.size(), 0, min, max, out);
+}
+
+void point_kd_tree_t::inside(size_t first, size_t last, int depth, const double min[2], const double max[2], std::vector<unsigned int> & out) const
+{
+	if(first >= last) {
+		return;
+	}
+	size_t middle = first + (last - first)/2;
+	const node_t & node = _nodes[middle];
+	if(min[0] <= node._x && node._x <= max[0] && min[1] <= node._y && node._y <= max[1]) {
+		out.push_back(node._point_id);
+	}
+	double split = (depth % 2 == 0)? node._x: node._y;
+	if(min[depth % 2] <= split) {
+		inside(first, middle, depth+1, min, max, out);
+	}
+	if(split <= max[depth % 2]) {
+		inside(middle+1, last, depth+1, min, max, out);
+	}
+}
+
+// Even-odd rule. Vertices are pixels, so their centers are compared with the point
+static bool is_inside(const std::vector<cv::Point> & polygon, double x, double y)
+{
+	if(polygon.size() < 3) {
+		return false;
+	}
+	bool is_inside = false;
+	for(size_t i=0, j=polygon.size()-1; i<polygon.size(); j=i++) {
+		double xi = polygon[i].x + 0.5, yi = polygon[i].y + 0.5;
+		double xj = polygon[j].x + 0.5, yj = polygon[j].y + 0.5;
+		if( (yi > y) != (yj > y) && x < xi + (y - yi) * (xj - xi) / (yj - yi) ) {
+			is_inside = !is_inside;
+		}
+	}
+	return is_inside;
+}
+
+int trajectory_picker_t::find(size_t frame_id, int x, int y, double radius)
+{
+	std::vector<unsigned int> trajectory_ids;
+	find(frame_id, x, y, radius, 1, trajectory_ids);
+	return trajectory_ids.empty()? not_found: (int)trajectory_ids[0];
+}
+
+void trajectory_picker_t::find(size_t frame_id, int x, int y, double radius, size_t k, std::vector<unsigned int> & trajectory_ids)
+{
+	trajectory_ids.clear();
+	if(frame_id >= _index.size()) {
+		return;
+	}
+	tree(frame_id).nearest(x + 0.5, y + 0.5, radius, k, _nearest);
+	frame_index_t::frame_points_t points = _index[frame_id];
+	for(const std::pair<double, unsigned int> & p : _nearest) {
+		trajectory_ids.push_back(points[p.second]._trajectory_id);
+	}
+}
+
+void trajectory_picker_t::find(size_t frame_id, const std::vector<cv::Point> & polygon, std::vector<unsigned int> & trajectory_ids)
+{
+	trajectory_ids.clear();
+	if(frame_id >= _index.size() || polygon.empty()) {
+		return;
+	}
+	double min_x = polygon[0].x, min_y = polygon[0].y, max_x = polygon[0].x, max_y = polygon[0].y;
+	for(const cv::Point & vertex : polygon) {
+		min_x = std::min<double>(min_x, vertex.x);
+		min_y = std::min<double>(min_y, vertex.y);
+		max_x = std::max<double>(max_x, vertex.x);
+		max_y = std::max<double>(max_y, vertex.y);
+	}
+	tree(frame_id).inside(min_x + 0.5, min_y + 0.5, max_x + 0.5, max_y + 0.5, _inside);
+	frame_index_t::frame_points_t points = _index[frame_id];
+	for(unsigned int point_id : _inside) {
+		if( is_inside(polygon, points[point_id]._x, points[point_id]._y) ) {
+			trajectory_ids.push_back(points[point_id]._trajectory_id);
+		}
+	}
+	std::sort(trajectory_ids.begin(), trajectory_ids.end());
+	trajectory_ids.erase(std::unique(trajectory_ids.begin(), trajectory_ids.end()), trajectory_ids.end());
+}
+
+void trajectory_picker_t::clear()
+{
+	_trees.clear();
+}
+
+const point_kd_tree_t & trajectory_picker_t::tree(size_t frame_id)
+{
+	if(_trees.size() != _index.size()) {
+		_trees.assign(_index.size(), point_kd_tree_t());
+	}
+	// points are only appended to frames, so a frame has changed since its tree was built iff it has more points now
+	if(_trees[frame_id].size() != _index[frame_id].size()) {
+		_trees[frame_id].build(_index[frame_id]);
+	}
+	return _trees[frame_id];
+}
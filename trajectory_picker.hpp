@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <utility> // pair
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "frame_index.hpp"
+
+// A 2d tree over points of a frame. The tree is implicit: points are reordered so that the median of a range by x (even depth)
+// or y (odd depth) is in its middle, points before it are not greater and points after it are not less
+class point_kd_tree_t
+{
+	public:
+	void build(frame_index_t::frame_points_t points);
+
+	// Up to k points closest to (x, y) within radius, as (squared distance, index of the point in the frame), nearest first
+	void nearest(double x, double y, double radius, size_t k, std::vector<std::pair<double, unsigned int> > & out) const;
+	// Indices of points in the frame within [min_x, max_x] x [min_y, max_y], in no particular order
+	void inside(double min_x, double min_y, double max_x, double max_y, std::vector<unsigned int> & out) const;
+
+	size_t size() const { return _nodes.size(); }
+
+	private:
+	struct node_t
+	{
+		float _x;
+		float _y;
+		unsigned int _point_id; // index of the point in the frame
+	}; // node_t
+
+	void build(size_t first, size_t last, int depth);
+	void search(size_t first, size_t last, int depth, double x, double y, double & max_distance, size_t k,
+			std::vector<std::pair<double, unsigned int> > & heap) const;
+	void inside(size_t first, size_t last, int depth, const double min[2], const double max[2], std::vector<unsigned int> & out) const;
+
+	std::vector<node_t> _nodes;
+}; // point_kd_tree_t
+
+// Picks trajectories by distance from a pixel to their points at a frame. A tree of a frame is built when the frame is picked
+// for the first time and kept until clear(), so only visited frames take memory. A frame which gains points
+// by frame_index_t::append() gets its tree rebuilt when it is picked next time, trees of other frames are kept
+class trajectory_picker_t
+{
+	public:
+	static const int not_found = -1;
+
+	explicit trajectory_picker_t(const frame_index_t & index): _index(index) { }
+
+	// Index of the trajectory with the point nearest to the center of the pixel within radius, or not_found
+	int find(size_t frame_id, int x, int y, double radius);
+	// Indices of up to k trajectories with points within radius from the center of the pixel, nearest first
+	void find(size_t frame_id, int x, int y, double radius, size_t k, std::vector<unsigned int> & trajectory_ids);
+	// Indices of trajectories, ascending and unique, with points inside the polygon of pixels (e.g. 4 corners of a rectangle or a lasso).
+	// Points of the bounding box of the polygon are found in the tree, then they are tested against the polygon
+	void find(size_t frame_id, const std::vector<cv::Point> & polygon, std::vector<unsigned int> & trajectory_ids);
+
+	// Must be called after the index is rebuilt
+	void clear();
+
+	private:
+	const point_kd_tree_t & tree(size_t frame_id);
+
+	const frame_index_t & _index;
+	std::vector<point_kd_tree_t> _trees; // a tree with less points than its frame is not built yet
+	std::vector<std::pair<double, unsigned int> > _nearest;
+	std::vector<unsigned int> _inside;
+}; // trajectory_picker_t
@@ -0,0 +1,115 @@
+#include "trajectory_rasterizer.hpp"
+
+#include <algorithm> // min max
+#include <atomic>
+#include <cassert>
+#include <cmath> // floor
+#include <thread>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+trajectory_rasterizer_t::trajectory_rasterizer_t(int indent): _indent(indent)
+{
+	const int hue_step_deg = 30;
+	const int amount_of_hues = 360 / hue_step_deg;
+
+	// the last color is the color of the first segment. Each color fills a long row, since vectorized conversion of frames
+	// may round differently than conversion of a few pixels, and colors must be the same as in frames converted from HSV
+	const int row_length = 256;
+	cv::Mat hsv_palette(amount_of_hues+1, row_length, CV_8UC3);
+	for(int i=0; i<=amount_of_hues; ++i) {
+		int hue = std::min(i*hue_step_deg, 255); // 8-bit hue of OpenCV is [0, 180), larger hues were saturated
+		cv::Vec3b hsv = (i < amount_of_hues)? cv::Vec3b(hue, 255, 255): cv::Vec3b(0, 0, 0);
+		cv::Vec3b * row = hsv_palette.ptr<cv::Vec3b>(i);
+		std::fill(row, row + row_length, hsv);
+	}
+
+	cv::Mat bgr_palette;
+	cv::cvtColor(hsv_palette, bgr_palette, CV_HSV2BGR);
+	for(int i=0; i<amount_of_hues; ++i) {
+		_palette.push_back(bgr_palette.at<cv::Vec3b>(i, 0));
+	}
+	_first_segment_color = bgr_palette.at<cv::Vec3b>(amount_of_hues, 0);
+}
+
+const cv::Vec3b & trajectory_rasterizer_t::color(unsigned int segment) const
+{
+	return (segment == 0)? _first_segment_color: _palette[segment % _palette.size()];
+}
+
+bool drawn_square(const frame_point_t & point, int indent, cv::Size frame_size, cv::Point & top_left, cv::Point & bottom_right)
+{
+	int floor_x = floor(point._x);
+	int floor_y = floor(point._y);
+	int ceil_x = floor_x + 1;
+	int ceil_y = floor_y + 1;
+
+	cv::Point p1, p2;
+	p1.x = (floor_x-indent<0)? 0: floor_x-indent;
+	p1.y = (floor_y-indent<0)? 0: floor_y-indent;
+	p2.x = (ceil_x+indent>=frame_size.width-1)? frame_size.width-1: ceil_x+indent;
+	p2.y = (ceil_y+indent>=frame_size.height-1)? frame_size.height-1: ceil_y+indent;
+
+	top_left.x = std::max(std::min(p1.x, p2.x), 0);
+	top_left.y = std::max(std::min(p1.y, p2.y), 0);
+	bottom_right.x = std::min(std::max(p1.x, p2.x), frame_size.width-1);
+	bottom_right.y = std::min(std::max(p1.y, p2.y), frame_size.height-1);
+	return top_left.x <= bottom_right.x && top_left.y <= bottom_right.y;
+}
+
+void trajectory_rasterizer_t::draw(const frame_index_t & index, size_t frame_id, cv::Mat & out) const
+{
+	assert(out.type() == CV_8UC3);
+	cv::Size frame_size(out.cols, out.rows);
+
+	for(const frame_point_t & point : index[frame_id]) {
+		cv::Point top_left, bottom_right;
+		if( !drawn_square(point, _indent, frame_size, top_left, bottom_right) ) {
+			continue;
+		}
+
+		const cv::Vec3b & bgr = color(point._segment);
+		for(int y=top_left.y; y<=bottom_right.y; ++y) {
+			cv::Vec3b * row = out.ptr<cv::Vec3b>(y);
+			std::fill(row + top_left.x, row + bottom_right.x + 1, bgr);
+		}
+	}
+}
+
+void trajectory_rasterizer_t::draw(const frame_index_t & index, size_t first, size_t last, const std::function<cv::Mat(size_t)> & source, bool is_rgb,
+		std::vector<cv::Mat> & out, unsigned int num_threads) const
+{
+	out.clear();
+	out.resize(last - first);
+
+	if(num_threads == 0) {
+		num_threads = std::thread::hardware_concurrency();
+	}
+	num_threads = std::min<size_t>(std::max(num_threads, 1u), out.size());
+
+	std::atomic<size_t> next_frame(first);
+	auto draw_frames = [&]() {
+		for(size_t frame_id = next_frame++; frame_id < last; frame_id = next_frame++) {
+			cv::Mat frame = source(frame_id);
+			if(frame.data == 0) {
+				continue;
+			}
+			cv::Mat & drawn_frame = out[frame_id - first];
+			if(is_rgb) {
+				cv::cvtColor(frame, drawn_frame, CV_RGB2BGR);
+			} else {
+				frame.copyTo(drawn_frame);
+			}
+			draw(index, frame_id, drawn_frame);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(unsigned int t=1; t<num_threads; ++t) {
+		workers.push_back(std::thread(draw_frames));
+	}
+	draw_frames();
+	for(std::thread & worker : workers) {
+		worker.join();
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "frame_index.hpp"
+
+// Pixels painted for a point: the square from (floor(x)-indent, floor(y)-indent) to (floor(x)+1+indent, floor(y)+1+indent),
+// corners inclusive, clamped to the frame as they were for cv::rectangle, which swaps them if they are reversed.
+// So a point far outside of the frame still paints its border. Returns false if no pixel is painted.
+// The rasterizer and frame_grid_t share it, so any drawn pixel is found by a click
+bool drawn_square(const frame_point_t & point, int indent, cv::Size frame_size, cv::Point & top_left, cv::Point & bottom_right);
+
+// Draws points of trajectories as filled squares directly into 8-bit BGR frames.
+// A partition segment of a trajectory has the color that drawing in HSV used to give it: black for the first segment,
+// then hues 30, 60, ... degrees (saturated to 8 bits as cv::Scalar did) with full saturation and value.
+// Colors are converted to BGR once, so frames are not converted to HSV and back
+class trajectory_rasterizer_t
+{
+	public:
+	// A point is drawn as a square from (floor(x)-indent, floor(y)-indent) to (floor(x)+1+indent, floor(y)+1+indent)
+	explicit trajectory_rasterizer_t(int indent);
+
+	const cv::Vec3b & color(unsigned int segment) const;
+
+	// Draws points of the frame into out (CV_8UC3)
+	void draw(const frame_index_t & index, size_t frame_id, cv::Mat & out) const;
+
+	// Draws copies of frames [first, last) into out[0 .. last-first) concurrently, since frames are independent.
+	// source(frame_id) returns a BGR or RGB frame, out[i] is BGR. out[i] is empty if the source frame is empty
+	void draw(const frame_index_t & index, size_t first, size_t last, const std::function<cv::Mat(size_t)> & source, bool is_rgb,
+			std::vector<cv::Mat> & out, unsigned int num_threads = 0) const;
+
+	private:
+	int _indent;
+	cv::Vec3b _first_segment_color;
+	std::vector<cv::Vec3b> _palette; // colors of other segments, segment k has color k % _palette.size()
+}; // trajectory_rasterizer_t
@@ -0,0 +1,133 @@
+#include "trajectory_store.hpp"
+#include <cassert>
+#include <algorithm> // copy
+
+void trajectory_store_t::clear()
+{
+	_x.clear();
+	_y.clear();
+	_start_frames.clear();
+	_offsets.assign(1, 0);
+}
+
+void trajectory_store_t::recreate(const std::vector<size_t> & lengths)
+{
+	_offsets.resize(lengths.size()+1);
+	_offsets[0] = 0;
+	for(size_t i=0; i<lengths.size(); ++i) {
+		_offsets[i+1] = _offsets[i] + lengths[i];
+	}
+	_start_frames.assign(lengths.size(), 0);
+	_x.assign(_offsets.back(), 0);
+	_y.assign(_offsets.back(), 0);
+}
+
+size_t trajectory_store_t::append(size_t length, unsigned int start_frame)
+{
+	_start_frames.push_back(start_frame);
+	_offsets.push_back(_offsets.back() + length);
+	_x.resize(_offsets.back(), 0);
+	_y.resize(_offsets.back(), 0);
+	return size()-1;
+}
+
+size_t trajectory_store_t::push_back(const trajectory_t & tr)
+{
+	size_t i = append(tr.size(), tr._start_frame);
+	size_t k = _offsets[i];
+	for(const point_t & p : tr) {
+		_x[k] = p.x;
+		_y[k] = p.y;
+		++k;
+	}
+	return i;
+}
+
+size_t trajectory_store_t::size() const
+{
+	return _start_frames.size();
+}
+
+size_t trajectory_store_t::amount_of_points() const
+{
+	return _offsets.back();
+}
+
+size_t trajectory_store_t::length(size_t i) const
+{
+	return _offsets[i+1] - _offsets[i];
+}
+
+unsigned int trajectory_store_t::start_frame(size_t i) const
+{
+	return _start_frames[i];
+}
+
+trajectory_store_t::components_t trajectory_store_t::x(size_t i) const
+{
+	assert(i < size());
+	return components_t(_x.data() + _offsets[i], length(i));
+}
+
+trajectory_store_t::components_t trajectory_store_t::y(size_t i) const
+{
+	assert(i < size());
+	return components_t(_y.data() + _offsets[i], length(i));
+}
+
+trajectory_store_t::point_t trajectory_store_t::point(size_t i, size_t j) const
+{
+	assert(j < length(i));
+	return point_t(_x[_offsets[i]+j], _y[_offsets[i]+j]);
+}
+
+void partition_store_t::clear()
+{
+	_cut_points.clear();
+	_offsets.assign(1, 0);
+}
+
+size_t partition_store_t::append(size_t size)
+{
+	_offsets.push_back(_offsets.back() + size);
+	_cut_points.resize(_offsets.back(), 0);
+	return this->size()-1;
+}
+
+size_t partition_store_t::push_back(const partition_t & pr)
+{
+	size_t i = append(pr.size());
+	std::copy(pr.begin(), pr.end(), _cut_points.begin() + _offsets[i]);
+	return i;
+}
+
+size_t partition_store_t::size() const
+{
+	return _offsets.size()-1;
+}
+
+size_t partition_store_t::amount_of_cut_points() const
+{
+	return _offsets.back();
+}
+
+partition_store_t::cut_points_t partition_store_t::operator[](size_t i) const
+{
+	assert(i < size());
+	return cut_points_t(_cut_points.data() + _offsets[i], _offsets[i+1] - _offsets[i]);
+}
+
+bool partition_store_t::fits(const trajectory_store_t & trajectories, size_t first, size_t last) const
+{
+	if(last > size() || last > trajectories.size()) {
+		return false;
+	}
+	for(size_t i=first; i<last; ++i) {
+		for(const cut_point_t & p : (*this)[i]) {
+			if(p >= trajectories.length(i)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
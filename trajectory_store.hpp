@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "trajectory_t.hpp"
+
+// Non-owning view of a contiguous array
+template<typename T>
+struct array_view_t
+{
+	typedef T value_type;
+	typedef const T * const_iterator;
+
+	array_view_t(): _data(0), _size(0) { }
+	array_view_t(const T * data, size_t size): _data(data), _size(size) { }
+
+	size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+	const T * data() const { return _data; }
+	const T & operator[](size_t i) const { return _data[i]; }
+	const T * begin() const { return _data; }
+	const T * end() const { return _data + _size; }
+
+	const T * _data;
+	size_t _size;
+}; // array_view_t
+
+// Coordinates as doubles: the column itself if components are doubles, otherwise they are decoded into buffer
+inline const double * as_doubles(const array_view_t<double> & components, std::vector<double> &)
+{
+	return components.data();
+}
+template<typename T>
+const double * as_doubles(const array_view_t<T> & components, std::vector<double> & buffer)
+{
+	buffer.assign(components.begin(), components.end());
+	return buffer.data();
+}
+
+// All trajectories of a video in a few flat arrays (structure of arrays).
+// Points of i-th trajectory are [_offsets[i], _offsets[i+1]) of _x and _y
+struct trajectory_store_t
+{
+	typedef trajectory_t::component_t component_t;
+	typedef trajectory_t::point_t point_t;
+	typedef array_view_t<component_t> components_t;
+
+	trajectory_store_t(): _offsets(1, 0) { }
+
+	void clear();
+	// Makes lengths.size() trajectories with given lengths. Coordinates and start frames are zeroed
+	void recreate(const std::vector<size_t> & lengths);
+	// Appends a trajectory of given length with zeroed coordinates. Returns its index
+	size_t append(size_t length, unsigned int start_frame);
+	size_t push_back(const trajectory_t & tr);
+
+	size_t size() const; // amount of trajectories
+	size_t amount_of_points() const;
+
+	size_t length(size_t i) const;
+	unsigned int start_frame(size_t i) const;
+	components_t x(size_t i) const;
+	components_t y(size_t i) const;
+	point_t point(size_t i, size_t j) const;
+
+	std::vector<component_t> _x;
+	std::vector<component_t> _y;
+	std::vector<unsigned int> _start_frames; // frames start from 0
+	std::vector<size_t> _offsets;
+}; // trajectory_store_t
+
+// Partitions of all trajectories in CSR layout.
+// Cut points of i-th trajectory are [_offsets[i], _offsets[i+1]) of _cut_points
+struct partition_store_t
+{
+	typedef partition_t::value_type cut_point_t;
+	typedef array_view_t<cut_point_t> cut_points_t;
+
+	partition_store_t(): _offsets(1, 0) { }
+
+	void clear();
+	// Appends a partition with given amount of zeroed cut points. Returns its index
+	size_t append(size_t size);
+	size_t push_back(const partition_t & pr);
+
+	size_t size() const; // amount of partitions
+	size_t amount_of_cut_points() const;
+
+	cut_points_t operator[](size_t i) const;
+
+	// True if every cut point of partitions [first, last) is an index of a point of the trajectory with the same index.
+	// Drawing and plotting index points by cut points, so partitions must be checked after they are read
+	bool fits(const trajectory_store_t & trajectories, size_t first, size_t last) const;
+
+	std::vector<cut_point_t> _cut_points;
+	std::vector<size_t> _offsets;
+}; // partition_store_t
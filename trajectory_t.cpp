@@ -69,8 +69,8 @@ void read_dat_header(int & video_length, int & amount_of_elements, std::ifstream
 void write_dat_header(int video_length, int amount_of_elements, std::ofstream & out)
 {
 	assert(out.is_open());
-	out << video_length << std::endl;
-	out << amount_of_elements << std::endl;
+	out << video_length << '\n';
+	out << amount_of_elements << '\n';
 }
 
 void read(trajectory_t & tr, std::ifstream & in)
@@ -97,15 +97,17 @@ void read(trajectory_t & tr, std::ifstream & in)
 }
 void write(const trajectory_t & tr, std::ofstream & out)
 {
-	assert(tr.size() > 0);
 	assert(out.is_open());
 
-	out << (int)0/*label*/ << ' ' << tr.size() << std::endl;
+	out << (int)0/*label*/ << ' ' << tr.size() << '\n';
+	if(tr.size() == 0) {
+		return;
+	}
 
 	unsigned int frame = tr._start_frame;
-	out << lroundf(tr[0].x) << ' ' << lroundf(tr[0].y) << ' ' << frame++ << std::endl;
+	out << lroundf(tr[0].x) << ' ' << lroundf(tr[0].y) << ' ' << frame++ << '\n';
 	for(trajectory_t::const_iterator it=1+tr.begin(); it!=tr.end(); ++it) {
-		out << it->x << ' ' << it->y << ' ' << frame++ << std::endl;
+		out << it->x << ' ' << it->y << ' ' << frame++ << '\n';
 	}
 }
 
@@ -126,9 +128,9 @@ void write(const partition_t & pr, std::ofstream & out)
 {
 	assert(out.is_open());
 
-	out << pr.size() << std::endl;
+	out << pr.size() << '\n';
 	for(partition_t::const_iterator cit=pr.begin(); cit!=pr.end(); ++cit) {
 		out << *cit << ' ';
 	}
-	out << std::endl;
+	out << '\n';
 }
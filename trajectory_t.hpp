@@ -3,12 +3,27 @@
 #include <vector>
 #include <list>
 #include <fstream>
+#include <cstdint>
 #include <opencv2/core/core.hpp> // cv::Point
+#include "fixed_point.hpp"
 
+// Storage type of coordinates is selected at build time (see PRECISION in Makefile):
+//	default				double, 8 bytes
+//	TRAJECTORY_COMPONENT_FLOAT	float, 4 bytes
+//	TRAJECTORY_COMPONENT_FIXED16_16	16.16 fixed point, 4 bytes, 1/65536 px
+//	TRAJECTORY_COMPONENT_FIXED12_4	12.4 fixed point, 2 bytes, 1/16 px, coordinates within +-2048 px
+// Fixed point coordinates are decoded to double on access
 struct trajectory_t
 {
-	//typedef float component_t;
+#if defined(TRAJECTORY_COMPONENT_FLOAT)
+	typedef float component_t;
+#elif defined(TRAJECTORY_COMPONENT_FIXED16_16)
+	typedef fixed_point_t<int32_t, 16> component_t;
+#elif defined(TRAJECTORY_COMPONENT_FIXED12_4)
+	typedef fixed_point_t<int16_t, 4> component_t;
+#else
 	typedef double component_t;
+#endif
 	typedef cv::Point_<component_t> point_t;
 
 	typedef std::vector<point_t>::iterator iterator;
@@ -0,0 +1,175 @@
+#include "trajectory_window.hpp"
+
+#include <algorithm> // sort copy
+
+#include "dat_scanner.hpp"
+
+bool trajectory_window_t::open(const std::string & path_to_trajectories, const std::string & path_to_partition)
+{
+	if( !_trajectories_file.open(path_to_trajectories) || !_partitions_file.open(path_to_partition) ) {
+		return false;
+	}
+	_ids.clear();
+	_first_frame = _last_frame = 0;
+
+	// index trajectories: only the first point of each record is parsed, other lines are skipped
+	dat_scanner_t trajectories_scanner(_trajectories_file.data(), _trajectories_file.end());
+	int amount;
+	if( !trajectories_scanner.next(_video_length) || !trajectories_scanner.next(amount) || amount < 0 ) {
+		return false;
+	}
+	_records.resize(amount);
+	for(record_t & record : _records) {
+		trajectories_scanner.skip_spaces();
+		record._trajectory_offset = trajectories_scanner.position() - _trajectories_file.data();
+
+		int label;
+		double x, y;
+		int frame = 0;
+		if( !trajectories_scanner.next(label) || !trajectories_scanner.next(record._length) ) {
+			return false;
+		}
+		if(record._length > 0) {
+			if( !trajectories_scanner.next(x) || !trajectories_scanner.next(y) || !trajectories_scanner.next(frame) ) {
+				return false;
+			}
+			if( !trajectories_scanner.skip_line() && record._length > 1 ) {
+				return false;
+			}
+			if( !trajectories_scanner.skip_lines(record._length-1) ) {
+				return false;
+			}
+		}
+		record._start_frame = frame;
+	}
+
+	// index partitions
+	dat_scanner_t partitions_scanner(_partitions_file.data(), _partitions_file.end());
+	int partitions_video_length;
+	if( !partitions_scanner.next(partitions_video_length) || !partitions_scanner.next(amount) ) {
+		return false;
+	}
+	if(partitions_video_length != _video_length || amount != (int)_records.size()) {
+		return false;
+	}
+	for(record_t & record : _records) {
+		partitions_scanner.skip_spaces();
+		record._partition_offset = partitions_scanner.position() - _partitions_file.data();
+
+		size_t size;
+		if( !partitions_scanner.next(size) ) {
+			return false;
+		}
+		// cut points must be points of the trajectory, since drawing and plotting index points by them
+		partition_t::value_type cut_point;
+		for(size_t i=0; i<size; ++i) {
+			if( !partitions_scanner.next(cut_point) || cut_point >= record._length ) {
+				return false;
+			}
+		}
+	}
+
+	std::vector<lifespan_index_t::lifespan_t> lifespans(_records.size());
+	for(size_t id=0; id<_records.size(); ++id) {
+		lifespans[id]._first_frame = _records[id]._start_frame;
+		lifespans[id]._last_frame = _records[id]._start_frame + _records[id]._length;
+		lifespans[id]._id = id;
+	}
+	_lifespans.build(lifespans);
+	return true;
+}
+
+// Parses a trajectory record at given offset and appends it to the store
+static bool read_trajectory(const mapped_file_t & file, size_t offset, trajectory_store_t & trajectories)
+{
+	dat_scanner_t scanner(file.data() + offset, file.end());
+	int label;
+	size_t length;
+	if( !scanner.next(label) || !scanner.next(length) ) {
+		return false;
+	}
+	size_t i = trajectories.append(length, 0);
+	trajectory_store_t::component_t * x = trajectories._x.data() + trajectories._offsets[i];
+	trajectory_store_t::component_t * y = trajectories._y.data() + trajectories._offsets[i];
+
+	double point_x, point_y;
+	int frame;
+	for(size_t j=0; j<length; ++j) {
+		if( !scanner.next(point_x) || !scanner.next(point_y) || !scanner.next(frame) ) {
+			return false;
+		}
+		x[j] = point_x;
+		y[j] = point_y;
+		if(j == 0) {
+			trajectories._start_frames[i] = frame;
+		}
+	}
+	return true;
+}
+
+// Parses a partition record at given offset and appends it to the store
+static bool read_partition(const mapped_file_t & file, size_t offset, partition_store_t & partitions)
+{
+	dat_scanner_t scanner(file.data() + offset, file.end());
+	size_t size;
+	if( !scanner.next(size) ) {
+		return false;
+	}
+	size_t i = partitions.append(size);
+	for(size_t j=partitions._offsets[i]; j<partitions._offsets[i+1]; ++j) {
+		if( !scanner.next(partitions._cut_points[j]) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool trajectory_window_t::set_window(unsigned int first_frame, unsigned int last_frame, trajectory_store_t & trajectories, partition_store_t & partitions)
+{
+	trajectory_store_t window_trajectories;
+	partition_store_t window_partitions;
+	std::vector<size_t> window_ids;
+
+	// ids of trajectories in the window, ascending as in the files
+	std::vector<size_t> ids;
+	_lifespans.overlapping(first_frame, last_frame, ids);
+	std::sort(ids.begin(), ids.end());
+
+	size_t k = 0; // position in _ids of previous window
+	for(size_t id : ids) {
+		const record_t & record = _records[id];
+		while(k < _ids.size() && _ids[k] < id) {
+			++k; // evicted
+		}
+
+		if(k < _ids.size() && _ids[k] == id) { // resident, copy from the previous window
+			size_t i = window_trajectories.append(trajectories.length(k), trajectories.start_frame(k));
+			std::copy(trajectories.x(k).begin(), trajectories.x(k).end(), window_trajectories._x.begin() + window_trajectories._offsets[i]);
+			std::copy(trajectories.y(k).begin(), trajectories.y(k).end(), window_trajectories._y.begin() + window_trajectories._offsets[i]);
+			size_t j = window_partitions.append(partitions[k].size());
+			std::copy(partitions[k].begin(), partitions[k].end(), window_partitions._cut_points.begin() + window_partitions._offsets[j]);
+		} else {
+			if( !read_trajectory(_trajectories_file, record._trajectory_offset, window_trajectories) ) {
+				return false;
+			}
+			if( !read_partition(_partitions_file, record._partition_offset, window_partitions) ) {
+				return false;
+			}
+		}
+		window_ids.push_back(id);
+	}
+
+	std::swap(trajectories, window_trajectories);
+	std::swap(partitions, window_partitions);
+	_ids.swap(window_ids);
+	_first_frame = first_frame;
+	_last_frame = last_frame;
+	return true;
+}
+
+bool trajectory_window_t::read(size_t id, trajectory_store_t & trajectories, partition_store_t & partitions) const
+{
+	const record_t & record = _records[id];
+	return read_trajectory(_trajectories_file, record._trajectory_offset, trajectories) &&
+		read_partition(_partitions_file, record._partition_offset, partitions);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "mapped_file.hpp"
+#include "trajectory_store.hpp"
+#include "lifespan_index.hpp"
+
+// Lazy loading of trajectories and their partitions by a range of frames.
+// open() builds a lightweight index of every trajectory (start frame, length and file offsets of both records),
+// set_window() keeps in memory only trajectories that exist in the window, so memory does not depend on video length
+class trajectory_window_t
+{
+	public:
+	struct record_t
+	{
+		unsigned int _start_frame;
+		size_t _length;
+		size_t _trajectory_offset; // offset of '<label> <length>' in the file of trajectories
+		size_t _partition_offset; // offset of '<length>' in the file of partitions
+	}; // record_t
+
+	trajectory_window_t(): _video_length(0), _first_frame(0), _last_frame(0) { }
+
+	// Both files are .dat. Returns false if they cannot be opened, are malformed or do not correspond to each other
+	bool open(const std::string & path_to_trajectories, const std::string & path_to_partition);
+
+	int video_length() const { return _video_length; }
+	size_t size() const { return _records.size(); } // amount of trajectories in the files
+	const record_t & record(size_t id) const { return _records[id]; }
+
+	// Makes the stores hold trajectories that exist in at least one frame of [first_frame, last_frame).
+	// Trajectories that are already in the stores are kept, others are read from the files. Returns false on a read error
+	bool set_window(unsigned int first_frame, unsigned int last_frame, trajectory_store_t & trajectories, partition_store_t & partitions);
+
+	unsigned int first_frame() const { return _first_frame; }
+	unsigned int last_frame() const { return _last_frame; }
+	bool contains(unsigned int frame) const { return _first_frame <= frame && frame < _last_frame; }
+
+	// Index of i-th trajectory of the stores in the files
+	size_t id(size_t i) const { return _ids[i]; }
+
+	// Appends the trajectory with given index in the files and its partition to the stores, regardless of the window.
+	// Returns false on a read error
+	bool read(size_t id, trajectory_store_t & trajectories, partition_store_t & partitions) const;
+
+	private:
+	mapped_file_t _trajectories_file;
+	mapped_file_t _partitions_file;
+	int _video_length;
+	std::vector<record_t> _records;
+	lifespan_index_t _lifespans; // of records, ids are indices of records
+
+	unsigned int _first_frame;
+	unsigned int _last_frame;
+	std::vector<size_t> _ids; // ids of trajectories in the stores, ascending
+}; // trajectory_window_t
@@ -0,0 +1,200 @@
+#include "video_reader.hpp"
+
+#include <algorithm> // lower_bound, adjacent_find
+#include <cmath> // fabs
+#include <fstream>
+#include <functional> // greater_equal
+#include <iomanip> // setprecision
+
+#include <sys/stat.h> // stat
+
+// Frames up to this distance ahead are reached by decoding all frames between, since seeking decodes from a keyframe anyway
+const size_t max_decoded_skip = 16;
+// Seeks that land after the requested frame are repeated that many times from earlier timestamps
+const int max_seek_attempts = 4;
+// A timestamp in the index is at least a digit and a line break
+const long long min_timestamp_bytes = 2;
+
+const size_t video_reader_t::unknown_position;
+
+bool video_reader_t::open(const std::string & path)
+{
+	_path = path;
+	_timestamps.clear();
+
+	struct stat st;
+	if(stat(path.c_str(), &st) != 0) {
+		return false;
+	}
+	// the index is rebuilt when the video is changed
+	long long file_size = st.st_size;
+	long long modification_time = st.st_mtime;
+	std::string path_to_index = path + ".idx";
+
+	if( !load_index(path_to_index, file_size, modification_time) ) {
+		if( !build_index(path) ) {
+			return false;
+		}
+		save_index(path_to_index, file_size, modification_time); // the video is still readable if the index is not saved
+	}
+
+	// some containers report no or broken timestamps, frames of them cannot be found after a seek
+	_is_seekable = std::adjacent_find(_timestamps.begin(), _timestamps.end(), std::greater_equal<double>()) == _timestamps.end();
+
+	_capture.release();
+	if( !_capture.open(path) ) {
+		return false;
+	}
+	_next_frame = 0;
+	return !_timestamps.empty();
+}
+
+cv::Mat video_reader_t::read(size_t frame_id)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if(frame_id >= _timestamps.size()) {
+		return cv::Mat();
+	}
+
+	// the last grabbed frame is always _next_frame-1. On a failure the position of _capture is not known,
+	// so the next call seeks
+	if(frame_id < _next_frame || (_is_seekable && frame_id > _next_frame + max_decoded_skip)) {
+		if( !seek(frame_id) ) {
+			_next_frame = unknown_position;
+			return cv::Mat();
+		}
+	}
+	while(_next_frame <= frame_id) {
+		if( !_capture.grab() ) {
+			_next_frame = unknown_position;
+			return cv::Mat();
+		}
+		++_next_frame;
+	}
+
+	cv::Mat frame;
+	if( !_capture.retrieve(frame) ) {
+		_next_frame = unknown_position;
+		return cv::Mat();
+	}
+	return frame;
+}
+
+// Grabs a frame at or before frame_id. If a seek lands after it, the seek is repeated from exponentially earlier
+// frames, and at last the video is decoded from the beginning. Without increasing timestamps it is always decoded
+// from the beginning
+bool video_reader_t::seek(size_t frame_id)
+{
+	size_t target = frame_id;
+	size_t step = 1;
+	for(int attempt=0; _is_seekable && attempt<max_seek_attempts; ++attempt) {
+		_capture.set(CV_CAP_PROP_POS_MSEC, _timestamps[target]);
+		size_t grabbed;
+		if( !_capture.grab() || !find_frame(_capture.get(CV_CAP_PROP_POS_MSEC), grabbed) ) {
+			break;
+		}
+		if(grabbed <= frame_id) {
+			_next_frame = grabbed + 1;
+			return true;
+		}
+		if(target == 0) {
+			break;
+		}
+		target = (target > step)? target - step: 0;
+		step *= 4;
+	}
+
+	_capture.release();
+	if( !_capture.open(_path) || !_capture.grab() ) {
+		return false;
+	}
+	_next_frame = 1;
+	return true;
+}
+
+// Index of the frame with the nearest timestamp. Returns false if the timestamp is not within half an interval
+// btw frames from it, i.e. it is not a timestamp of the indexed video
+bool video_reader_t::find_frame(double timestamp, size_t & frame_id) const
+{
+	std::vector<double>::const_iterator it = std::lower_bound(_timestamps.begin(), _timestamps.end(), timestamp);
+	if(it == _timestamps.end() || (it != _timestamps.begin() && timestamp - *(it-1) < *it - timestamp)) {
+		--it;
+	}
+	frame_id = it - _timestamps.begin();
+
+	double interval = 0;
+	if(frame_id+1 < _timestamps.size()) {
+		interval = _timestamps[frame_id+1] - _timestamps[frame_id];
+	} else if(frame_id > 0) {
+		interval = _timestamps[frame_id] - _timestamps[frame_id-1];
+	}
+	return _timestamps.size() == 1 || fabs(timestamp - _timestamps[frame_id]) <= interval/2;
+}
+
+bool video_reader_t::load_index(const std::string & path, long long file_size, long long modification_time)
+{
+	std::ifstream in(path);
+	if( !in.is_open() ) {
+		return false;
+	}
+	in.seekg(0, std::ios::end);
+	long long index_size = in.tellg();
+	in.seekg(0, std::ios::beg);
+
+	long long indexed_file_size, indexed_modification_time;
+	size_t amount_of_frames;
+	in >> indexed_file_size >> indexed_modification_time >> _frame_size.width >> _frame_size.height >> amount_of_frames;
+	if( !in || indexed_file_size != file_size || indexed_modification_time != modification_time ) {
+		return false;
+	}
+	// a broken index is rebuilt rather than trusted with the amount of timestamps to allocate
+	long long bytes_left = index_size - (long long)in.tellg();
+	if( _frame_size.width <= 0 || _frame_size.height <= 0 || amount_of_frames > (unsigned long long)bytes_left / min_timestamp_bytes ) {
+		return false;
+	}
+
+	_timestamps.resize(amount_of_frames);
+	for(double & timestamp : _timestamps) {
+		in >> timestamp;
+	}
+	if( !in ) {
+		_timestamps.clear();
+		return false;
+	}
+	return true;
+}
+
+bool video_reader_t::build_index(const std::string & path)
+{
+	cv::VideoCapture capture(path);
+	if( !capture.isOpened() ) {
+		return false;
+	}
+
+	cv::Mat frame;
+	while( capture.grab() ) {
+		if(_timestamps.empty()) {
+			if( !capture.retrieve(frame) ) {
+				return false;
+			}
+			_frame_size = frame.size();
+		}
+		_timestamps.push_back(capture.get(CV_CAP_PROP_POS_MSEC));
+	}
+	return !_timestamps.empty();
+}
+
+bool video_reader_t::save_index(const std::string & path, long long file_size, long long modification_time) const
+{
+	std::ofstream out(path);
+	if( !out.is_open() ) {
+		return false;
+	}
+	out << file_size << ' ' << modification_time << '\n';
+	out << _frame_size.width << ' ' << _frame_size.height << ' ' << _timestamps.size() << '\n';
+	out << std::setprecision(12);
+	for(double timestamp : _timestamps) {
+		out << timestamp << '\n';
+	}
+	return (bool)out;
+}
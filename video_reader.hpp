@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+// Frames of a video file decoded on demand by cv::VideoCapture.
+// Amount of frames and their timestamps reported by containers are not reliable, so on the first open the video is
+// scanned once and a seek index (timestamp of every frame) is saved next to it as <path>.idx.
+// Next frames are decoded sequentially, other frames are reached by seeking to their timestamps.
+// A seek lands on a nearby keyframe rather than on the exact frame, so the frame it lands on is found in the index
+// by its timestamp and the following frames are decoded up to the requested one.
+// If timestamps of frames do not increase, frames before the decoded one are reached by decoding from the beginning
+class video_reader_t
+{
+	public:
+	video_reader_t(): _next_frame(0), _is_seekable(false) { }
+
+	bool open(const std::string & path);
+
+	size_t size() const { return _timestamps.size(); }
+	cv::Size frame_size() const { return _frame_size; }
+
+	// Returns an empty matrix on failure. Can be called from several threads
+	cv::Mat read(size_t frame_id);
+
+	private:
+	bool seek(size_t frame_id);
+	bool find_frame(double timestamp, size_t & frame_id) const;
+
+	bool load_index(const std::string & path, long long file_size, long long modification_time);
+	bool build_index(const std::string & path);
+	bool save_index(const std::string & path, long long file_size, long long modification_time) const;
+
+	cv::VideoCapture _capture;
+	std::string _path;
+	std::vector<double> _timestamps; // ms
+	cv::Size _frame_size;
+	size_t _next_frame; // frame that is decoded by the next grab of _capture, unknown_position after a failure
+	static const size_t unknown_position = (size_t)-1;
+	bool _is_seekable; // timestamps strictly increase, so a frame is found by the timestamp a seek lands on
+	std::mutex _mutex;
+}; // video_reader_t